@@ -6,6 +6,7 @@ import gnu.io.SerialPort;
 import gnu.io.SerialPortEvent; 
 import gnu.io.SerialPortEventListener; 
 import java.util.Enumeration;
+import java.util.TreeMap;
 
 
 public class Serial implements SerialPortEventListener {
@@ -13,7 +14,19 @@ public class Serial implements SerialPortEventListener {
 	SerialPort serialPort;
 	Function F = new Function("Humidity Data");
 	Function tester = new Function("TEST");
+	/** Graphs for channels other than channel 0, by channel number */
+	TreeMap<Integer, Function> channels = new TreeMap<Integer, Function>();
 	double count = 0;
+	/** Number of records the device said it will send */
+	int total = 510;
+	/** Rebuilt time of the last record in seconds, -1 until the first anchor */
+	long time = -1;
+	/** Time of the first record, used as the start of the x-axis */
+	long start_time = -1;
+	/** Uptime of the last unsynced anchor, -1 if there was none */
+	long last_uptime = -1;
+	/** Rebuilt time minus uptime for the current power-up */
+	long uptime_base = 0;
         /** The port we're normally going to use. */
 	private static final String PORT_NAMES[] = { 
 			"/dev/tty.usbserial-A9007UX1", // Mac OS X
@@ -82,6 +95,10 @@ public class Serial implements SerialPortEventListener {
 			// add event listeners
 			serialPort.addEventListener(this);
 			serialPort.notifyOnDataAvailable(true);
+
+			// time sync handshake, the device waits for this before sending data
+			output.write(("T" + (System.currentTimeMillis() / 1000) + "\n").getBytes());
+			output.flush();
 		} catch (Exception e) {
 			System.err.println(e.toString());
 		}
@@ -102,25 +119,62 @@ public class Serial implements SerialPortEventListener {
 
 	/**
 	 * Handle an event on the serial port. Read the data and print it.
+	 *
+	 * Lines sent by the device:
+	 *   #count        number of records that follow
+	 *   @time         anchor holding host time in seconds
+	 *   ~time         anchor holding device uptime in seconds
+	 *   delta,value   channel 0 sample taken delta seconds after the previous record
+	 *   +channel,value   sample of another channel taken with the record before
+	 *   -1            memory has been reset
+	 *   !task,stuck,loop times   the device restarted after hanging (see LoopWatch.h)
 	 */
 	public synchronized void serialEvent(SerialPortEvent oEvent) {
 		if (oEvent.getEventType() == SerialPortEvent.DATA_AVAILABLE) {
 			try {
 				String inputLine=input.readLine();
 				
-				double input_val =  Double.parseDouble(inputLine);
-				if(input_val<0){
+				if(inputLine.startsWith("!")){
+					System.out.println("Device restarted after hanging (task,ms stuck,last loop times): " + inputLine.substring(1));
+					return;
+				}else if(inputLine.startsWith("#")){
+					total = Integer.parseInt(inputLine.substring(1));
+					count = 0;
+					return;
+				}else if(inputLine.startsWith("@")){
+					time = Long.parseLong(inputLine.substring(1));
+					last_uptime = -1;
+				}else if(inputLine.startsWith("~")){
+					addUptimeAnchor(Long.parseLong(inputLine.substring(1)));
+				}else if(inputLine.startsWith("+")){
+					String[] sample = inputLine.substring(1).split(",");
+					int channel = Integer.parseInt(sample[0]);
+					if(!channels.containsKey(channel)){
+						channels.put(channel, new Function("Channel " + channel));
+					}
+					channels.get(channel).add((time - start_time) / 60.0, Double.parseDouble(sample[1]));
+				}else if(inputLine.indexOf(',') >= 0){
+					String[] sample = inputLine.split(",");
+					if(time < 0){
+						time = 0;
+					}
+					time += Long.parseLong(sample[0]);
+					if(start_time < 0){
+						start_time = time;
+					}
+					//x-axis in minutes since the first sample
+					F.add((time - start_time) / 60.0, Double.parseDouble(sample[1]));
+				}else if(Double.parseDouble(inputLine)<0){
 					System.out.println();
 					System.out.println("Memory has been reset.");
-				}else{
-					//System.out.print(inputLine);
-					F.add(count,input_val);
-					drawProgressBar((int)count, 510);
-				}
-				count ++; 
-				if(count==510){
 					F.show();
+					for(Function channel : channels.values()){
+						channel.show();
+					}
+					return;
 				}
+				count ++; 
+				drawProgressBar((int)count, Math.max(total, 1));
 
 
 
@@ -133,6 +187,23 @@ public class Serial implements SerialPortEventListener {
 		
 	}
 
+	/**
+	 * Place an anchor that only knows the device uptime.
+	 * Within one power-up the uptime difference is the real gap.
+	 * If the uptime went backwards the device lost power and the
+	 * gap is unknown, so the samples continue from the last known time.
+	 */
+	private void addUptimeAnchor(long uptime) {
+		if(time < 0){
+			time = 0;
+		}
+		if(last_uptime < 0 || uptime < last_uptime){
+			uptime_base = time - uptime;
+		}
+		time = uptime_base + uptime;
+		last_uptime = uptime;
+	}
+
 	/**
 	 * Draw a status bar
 	 * code courtesy of
@@ -0,0 +1,370 @@
+/*####################################################################
+ * FILE: Benchmark.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Times the pieces of the sketch on the board itself and
+ *          sends the results over Serial as JSON, one object per
+ *          line, so runs from different versions can be compared.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Only built when R24U_BENCHMARK is defined at the top of
+ *        sensational_toy.ino. The sketch then waits for the Serial
+ *        monitor, runs every benchmark and carries on as normal.
+ *
+ *        Timer 1 counts every CPU cycle while a benchmark runs (its
+ *        overflows are counted in an interrupt), so the results are
+ *        in cycles, F_CPU of them per second. The cost of reading
+ *        the timer is measured first and taken off every result.
+ *        millis() keeps ticking meanwhile, so "min" is the steadiest
+ *        number to compare, "mean" and "max" include its interrupts.
+ *
+ *        The benchmarks run on the device itself, so the timings
+ *        include the interrupts it really has, but the log is
+ *        switched to a small one in RAM and everything the log and
+ *        channel 0 keep is saved first and put back after, so the
+ *        real log and readings are left alone. The DHT22 benchmarks
+ *        use a sensor object of their own on DHTPIN. A second device
+ *        would not fit in the Leonardo's SRAM. Nothing a benchmark
+ *        times prints or waits: log_decode is the part of readData()
+ *        that walks the log, without its Serial output and delays.
+ *        "sd" is the standard deviation of the runs.
+ *
+ *        Output:
+ *          {"bench":"r24u","f_cpu":16000000,"overhead":cycles}
+ *          {"name":"...","runs":n,"min":cycles,"mean":cycles,"max":cycles,"sd":cycles}
+ *          {"done":1}
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <util/atomic.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define BENCH_LOG_BYTES 96 //size of the RAM log the memory benchmarks use
+#define BENCH_READ_RECORDS 8 //records in the log while log_decode() is timed
+
+/***************************
+ * RAM LOG
+ ***************************/
+class RAMStorage : public LogStorage
+{
+  public:
+    uint32_t size() { return BENCH_LOG_BYTES; }
+    uint16_t blockSize() { return 1; }
+    uint8_t read(uint32_t address) { return _bytes[address]; }
+    void write(uint32_t address, uint8_t value) { _bytes[address] = value; }
+    void erase(uint32_t from, uint32_t to) { memset(_bytes + from, LOG_BLANK, to - from); }
+    void sync() {}
+
+  private:
+    uint8_t _bytes[BENCH_LOG_BYTES];
+};
+
+/***************************
+ * BENCHMARK VARIABLES
+ ***************************/
+volatile unsigned long bench_overflows = 0; //timer 1 overflows, 65536 cycles each
+RAMStorage bench_store;
+dht22 bench_dht;
+climate bench_climate;
+volatile int bench_sink; //results are stored here so they aren't optimised away
+
+//what the benchmarks change in the device,
+//put back once they are done
+struct bench_saved
+{
+  LogStorage *log_store;
+  unsigned long log_header;
+  long log_slots;
+  unsigned int log_base;
+  long address_val;
+  int control_val;
+  long clear_next;
+  long clear_end;
+  unsigned long rom_last_time;
+  int rom_anchor_count;
+  int rom_ticks;
+  int rom_sample_delay;
+  int rom_due;
+  int rom_last_val[MAX_CHANNELS];
+  int channel_val;
+  unsigned long channel_time;
+  stats channel_stats;
+};
+
+struct bench
+{
+  const char *name;
+  void (*prepare)(); //run before each timed call, not timed, may be 0
+  void (*run)();
+  uint8_t runs;
+};
+
+/***************************
+ * BENCHMARK FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void bench_save(bench_saved*)
+ *   void bench_restore(bench_saved*)
+ *   unsigned long bench_cycles()
+ *   unsigned long bench_time(bench*, unsigned long)
+ *   void run_benchmarks()
+ *   (one function per benchmark)
+ ***************************/
+ISR(TIMER1_OVF_vect){
+  bench_overflows++;
+}
+/**
+ * keep the log position and channel 0,
+ * which the memory benchmarks change
+ */
+void bench_save(bench_saved *saved){
+  saved->log_store = ctx->log_store;
+  saved->log_header = ctx->log_header;
+  saved->log_slots = ctx->log_slots;
+  saved->log_base = ctx->log_base;
+  saved->address_val = ctx->address_val;
+  saved->control_val = ctx->control_val;
+  saved->clear_next = ctx->clear_next;
+  saved->clear_end = ctx->clear_end;
+  saved->rom_last_time = ctx->rom_last_time;
+  saved->rom_anchor_count = ctx->rom_anchor_count;
+  saved->rom_ticks = ctx->rom_ticks;
+  saved->rom_sample_delay = ctx->rom_sample_delay;
+  saved->rom_due = ctx->rom_due;
+  memcpy(saved->rom_last_val, ctx->rom_last_val, sizeof(saved->rom_last_val));
+  saved->channel_val = ctx->channel_val[0];
+  saved->channel_time = ctx->channel_time[0];
+  saved->channel_stats = ctx->channel_stats[0];
+}
+/**
+ * put back what bench_save() kept
+ */
+void bench_restore(bench_saved *saved){
+  ctx->log_store = saved->log_store;
+  ctx->log_header = saved->log_header;
+  ctx->log_slots = saved->log_slots;
+  ctx->log_base = saved->log_base;
+  ctx->address_val = saved->address_val;
+  ctx->control_val = saved->control_val;
+  ctx->clear_next = saved->clear_next;
+  ctx->clear_end = saved->clear_end;
+  ctx->rom_last_time = saved->rom_last_time;
+  ctx->rom_anchor_count = saved->rom_anchor_count;
+  ctx->rom_ticks = saved->rom_ticks;
+  ctx->rom_sample_delay = saved->rom_sample_delay;
+  ctx->rom_due = saved->rom_due;
+  memcpy(ctx->rom_last_val, saved->rom_last_val, sizeof(saved->rom_last_val));
+  ctx->channel_val[0] = saved->channel_val;
+  ctx->channel_time[0] = saved->channel_time;
+  ctx->channel_stats[0] = saved->channel_stats;
+}
+/**
+ * cycles counted by timer 1 so far
+ */
+unsigned long bench_cycles(){
+  unsigned long high;
+  unsigned int low;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    low = TCNT1;
+    high = bench_overflows;
+    //an overflow that happened since interrupts were held off
+    if((TIFR1 & _BV(TOV1)) && low < 0x8000){
+      high++;
+    }
+  }
+  return (high << 16) | low;
+}
+
+void bench_empty(){
+}
+
+void bench_fill_leds(){
+  fill_leds(15);
+}
+
+void bench_humidity_to_leds(){
+  bench_sink = humidity_to_leds(bench_sink + 55);
+}
+
+void bench_echo_to_cm(){
+  bench_sink = echo_to_cm(bench_sink + 580);
+}
+
+void bench_prepare_write(){
+  //start again before the RAM log fills up
+  if(ctx->address_val + ANCHOR_BYTES + MAX_CHANNELS > ctx->log_slots){
+    clearData(ctx->address_val);
+    ctx->address_val = 0;
+  }
+  ctx->control_val = WRITE;
+  set_channel(0, 40 + (ctx->address_val & 7));
+}
+
+void bench_mem_write(){
+  mem_write();
+}
+
+void bench_prepare_read(){
+  clearData(ctx->address_val);
+  ctx->address_val = 0;
+  ctx->rom_anchor_count = ANCHOR_PERIOD;
+  while(ctx->address_val < BENCH_READ_RECORDS){
+    bench_prepare_write();
+    mem_write();
+  }
+}
+
+void bench_log_decode(){
+  struct log_line line;
+  for(long i = 0; i<ctx->address_val; ){
+    i = log_decode(i, &line);
+    bench_sink = line.value;
+  }
+}
+
+void bench_prepare_dht(){
+  //the sensor needs DHT22_PERIOD_MS between reads
+  delay(DHT22_PERIOD_MS);
+  bench_dht.start();
+  delayMicroseconds(DHT22_START_US);
+}
+
+void bench_dht_finish(){
+  bench_sink = bench_dht.finish();
+}
+
+void bench_dew_point(){
+  bench_sink = bench_dht.dewPoint();
+}
+
+void bench_dew_point_fast(){
+  bench_sink = bench_dht.dewPointFast();
+}
+
+void bench_climate_update(){
+  climate_update(&bench_climate, 215 + (bench_sink & 7), 455);
+  bench_sink = bench_climate.dew10;
+}
+
+void bench_play_sounds(){
+  speakjet.print(humidity_sounds);
+}
+
+const bench benchmarks[] = {
+  {"fill_leds", 0, bench_fill_leds, 32},
+  {"humidity_to_leds", 0, bench_humidity_to_leds, 32},
+  {"echo_to_cm", 0, bench_echo_to_cm, 32},
+  {"mem_write", bench_prepare_write, bench_mem_write, 32},
+  {"log_decode", bench_prepare_read, bench_log_decode, 32},
+  {"dht22_finish", bench_prepare_dht, bench_dht_finish, 4},
+  {"dewPoint", 0, bench_dew_point, 16},
+  {"dewPointFast", 0, bench_dew_point_fast, 16},
+  {"climate_update", 0, bench_climate_update, 32},
+  {"play_sounds", 0, bench_play_sounds, 4}
+};
+/**
+ * time each run of a benchmark and print
+ * its line. overhead is taken off each run.
+ * returns the fastest run.
+ */
+unsigned long bench_time(const bench *b, unsigned long overhead){
+  unsigned long fastest = 0xFFFFFFFFUL;
+  unsigned long slowest = 0;
+  unsigned long total = 0;
+  //running mean and sum of squared differences (Welford),
+  //the squares of long runs don't fit an unsigned long
+  float mean = 0;
+  float squares = 0;
+  for(uint8_t i = 0; i<b->runs; i++){
+    if(b->prepare){
+      b->prepare();
+    }
+    unsigned long begin = bench_cycles();
+    b->run();
+    unsigned long cycles = bench_cycles() - begin;
+    cycles = cycles > overhead ? cycles - overhead : 0;
+    fastest = min(fastest, cycles);
+    slowest = max(slowest, cycles);
+    total += cycles;
+    float diff = cycles - mean;
+    mean += diff / (i + 1);
+    squares += diff * (cycles - mean);
+  }
+  if(b->name){
+    Serial.print(F("{\"name\":\""));
+    Serial.print(b->name);
+    Serial.print(F("\",\"runs\":"));
+    Serial.print(b->runs);
+    Serial.print(F(",\"min\":"));
+    Serial.print(fastest);
+    Serial.print(F(",\"mean\":"));
+    Serial.print(total / b->runs);
+    Serial.print(F(",\"max\":"));
+    Serial.print(slowest);
+    Serial.print(F(",\"sd\":"));
+    Serial.print(sqrt(squares / b->runs), 0);
+    Serial.println('}');
+  }
+  return fastest;
+}
+/**
+ * run every benchmark with the log in RAM,
+ * then hand timer 1, the log and channel 0
+ * back as they were.
+ *
+ * used in Setup(), after setup_bargraph()
+ * and log_recover();
+ */
+void run_benchmarks(){
+  bench_saved saved;
+  uint8_t saved_tccr1a = TCCR1A;
+  uint8_t saved_tccr1b = TCCR1B;
+  uint8_t saved_timsk1 = TIMSK1;
+
+  bench_save(&saved);
+  speakjet.begin(9600);
+  bench_dht.attach(ctx->DHTPIN);
+  //a reading for the dew point benchmarks until one is read
+  bench_dht.humidity = 45.5;
+  bench_dht.temperature = 21.5;
+  //start the RAM log blank, as a new EEPROM would be
+  bench_store.erase(0, BENCH_LOG_BYTES);
+  ctx->clear_end = 0;
+  set_log_storage(&bench_store);
+  log_recover();
+
+  //count every cycle, with no prescaler
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TCNT1 = 0;
+  bench_overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+
+  const bench calibrate = {0, 0, bench_empty, 32};
+  unsigned long overhead = bench_time(&calibrate, 0);
+  Serial.print(F("{\"bench\":\"r24u\",\"f_cpu\":"));
+  Serial.print(F_CPU);
+  Serial.print(F(",\"overhead\":"));
+  Serial.print(overhead);
+  Serial.println('}');
+
+  for(unsigned int i = 0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++){
+    bench_time(&benchmarks[i], overhead);
+  }
+  Serial.println(F("{\"done\":1}"));
+
+  TIMSK1 = saved_timsk1;
+  TCCR1A = saved_tccr1a;
+  TCCR1B = saved_tccr1b;
+  bench_restore(&saved);
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,182 @@
+/*####################################################################
+ * FILE: Climate.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Dew point, heat index and absolute humidity worked out from
+ *          a DHT22 reading with small tables and whole number math.
+ *          dht22::dewPoint() needs pow() and log(), which take
+ *          milliseconds each on the AVR, these take a few microseconds.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Temperatures are in tenths of a degree C and humidity in
+ *        tenths of a percent, the same resolution the DHT22 reads.
+ *
+ *        Checked against dht22::dewPoint() and the formulas the
+ *        tables were built from at every tenth from -40 to 60 C and
+ *        1 to 100 %: the dew point is within 0.25 C (dew points below
+ *        -40 C read as -40 C) and the absolute humidity within
+ *        0.2 g/m3. The heat index is within 0.4 C from 28 to 46 C.
+ *        Between 26 and 28 C the NOAA formula jumps where it switches
+ *        from its simple to its full form, and the table smooths that
+ *        over by up to 1.5 C. tools/climate_check.cpp runs this check.
+ *
+ *        The heat index only means something when it is warm, so
+ *        below CLIMATE_HI_MIN it is just the temperature.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef CLIMATE_H
+#define CLIMATE_H
+
+#include <avr/pgmspace.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define CLIMATE_ES_MIN -400 //first saturation pressure entry (tenths C)
+#define CLIMATE_ES_STEP 25 //tenths C between entries
+#define CLIMATE_ES_COUNT 41
+
+#define CLIMATE_HI_MIN 260 //first heat index row (tenths C)
+#define CLIMATE_HI_STEP 20 //tenths C between rows
+#define CLIMATE_HI_ROWS 11
+#define CLIMATE_HI_RH_STEP 100 //tenths % between columns
+#define CLIMATE_HI_COLS 11
+
+//saturation vapour pressure of water in half pascals, every 2.5 C
+//from -40 to 60 C, from the Goff-Gratch equation dht22::dewPoint() uses
+const uint16_t climate_es[CLIMATE_ES_COUNT] PROGMEM = {
+     38,    49,    63,    80,   102,   128,   161,   202,
+    251,   310,   382,   469,   572,   696,   843,  1017,
+   1221,  1462,  1744,  2072,  2454,  2897,  3408,  3997,
+   4674,  5449,  6333,  7341,  8485,  9781, 11246, 12897,
+  14754, 16837, 19170, 21774, 24677, 27906, 31490, 35461,
+  39850
+};
+
+//NOAA (Rothfusz) heat index in tenths C, rows every 2 C from 26 to 46 C,
+//columns every 10 % from 0 to 100 %
+const int16_t climate_hi[CLIMATE_HI_ROWS][CLIMATE_HI_COLS] PROGMEM = {
+  { 247,  249,  252,  254,  257,  260,  262,  265,  267,  270,  273},
+  { 258,  264,  267,  271,  277,  284,  294,  307,  321,  340,  364},
+  { 272,  279,  282,  288,  297,  310,  328,  350,  377,  408,  444},
+  { 287,  294,  300,  308,  323,  344,  371,  404,  444,  490,  542},
+  { 301,  311,  320,  333,  354,  384,  422,  468,  522,  584,  655},
+  { 316,  328,  342,  362,  391,  431,  481,  542,  612,  692,  782},
+  { 332,  347,  367,  394,  434,  486,  550,  625,  713,  812,  924},
+  { 347,  367,  394,  431,  483,  548,  626,  719,  825,  945, 1079},
+  { 363,  388,  423,  472,  537,  617,  712,  823,  949, 1090, 1248},
+  { 379,  410,  455,  517,  596,  693,  806,  936, 1084, 1249, 1430},
+  { 393,  432,  490,  566,  662,  776,  909, 1060, 1230, 1419, 1627}
+};
+
+/***************************
+ * RESULTS
+ * one per sensor, kept up to date
+ * by climate_update()
+ ***************************/
+struct climate
+{
+  int dew10; //dew point, tenths C
+  int heat10; //heat index, tenths C
+  int abs10; //absolute humidity, tenths g/m3
+  uint8_t es_index; //table entry the last dew point was found at
+};
+
+/***************************
+ * CLIMATE FUNCTION(S)
+ *
+ * CONTENTS:
+ *   long climate_es_at(int)
+ *   int climate_dew_point(long, uint8_t*)
+ *   int climate_heat_index(int, int)
+ *   int climate_abs_humidity(int, long)
+ *   void climate_update(climate*, int, int)
+ ***************************/
+/**
+ * saturation vapour pressure at a temperature,
+ * read between the two nearest table entries.
+ * it is left in 1/50 Pa (half pascals times the
+ * CLIMATE_ES_STEP) so nothing is lost dividing.
+ */
+inline long climate_es_at(int temp10){
+  int offset = constrain(temp10, CLIMATE_ES_MIN, CLIMATE_ES_MIN + CLIMATE_ES_STEP*(CLIMATE_ES_COUNT-1)) - CLIMATE_ES_MIN;
+  uint8_t i = min(offset / CLIMATE_ES_STEP, CLIMATE_ES_COUNT - 2);
+  long low = pgm_read_word(&climate_es[i]);
+  long high = pgm_read_word(&climate_es[i+1]);
+  return low*CLIMATE_ES_STEP + (high - low)*(offset - i*CLIMATE_ES_STEP);
+}
+/**
+ * temperature (tenths C) at which air holding
+ * vapour at pressure e (1/50 Pa) is saturated.
+ *
+ * the search starts at the entry the last
+ * reading was found at, since readings a few
+ * seconds apart land in the same or the next
+ * entry, and leaves the new one in *index.
+ * below the table it gives CLIMATE_ES_MIN.
+ */
+inline int climate_dew_point(long e, uint8_t *index){
+  uint8_t i = min(*index, (uint8_t)(CLIMATE_ES_COUNT - 2));
+  while(i > 0 && (long)pgm_read_word(&climate_es[i])*CLIMATE_ES_STEP > e){
+    i--;
+  }
+  while(i < CLIMATE_ES_COUNT - 2 && (long)pgm_read_word(&climate_es[i+1])*CLIMATE_ES_STEP <= e){
+    i++;
+  }
+  *index = i;
+  long low = pgm_read_word(&climate_es[i]);
+  long high = pgm_read_word(&climate_es[i+1]);
+  //one entry is CLIMATE_ES_STEP tenths, and e is already
+  //scaled by CLIMATE_ES_STEP, so the division gives tenths
+  long step = constrain(e - low*CLIMATE_ES_STEP, 0L, (high - low)*CLIMATE_ES_STEP);
+  return CLIMATE_ES_MIN + i*CLIMATE_ES_STEP + (step + (high - low)/2) / (high - low);
+}
+/**
+ * heat index (tenths C), read between the
+ * four nearest table entries. past the
+ * hottest row the last row is used.
+ */
+inline int climate_heat_index(int temp10, int rh10){
+  if(temp10 < CLIMATE_HI_MIN){
+    return temp10;
+  }
+  int t = min(temp10 - CLIMATE_HI_MIN, CLIMATE_HI_STEP*(CLIMATE_HI_ROWS-1));
+  int h = constrain(rh10, 0, CLIMATE_HI_RH_STEP*(CLIMATE_HI_COLS-1));
+  uint8_t r = min(t / CLIMATE_HI_STEP, CLIMATE_HI_ROWS - 2);
+  uint8_t c = min(h / CLIMATE_HI_RH_STEP, CLIMATE_HI_COLS - 2);
+  long tf = t - r*CLIMATE_HI_STEP;
+  long hf = h - c*CLIMATE_HI_RH_STEP;
+  long a = (int)pgm_read_word(&climate_hi[r][c]);
+  long b = (int)pgm_read_word(&climate_hi[r][c+1]);
+  long d = (int)pgm_read_word(&climate_hi[r+1][c]);
+  long e = (int)pgm_read_word(&climate_hi[r+1][c+1]);
+  long top = a*CLIMATE_HI_RH_STEP + (b - a)*hf;
+  long bottom = d*CLIMATE_HI_RH_STEP + (e - d)*hf;
+  return (top*CLIMATE_HI_STEP + (bottom - top)*tf) / ((long)CLIMATE_HI_STEP*CLIMATE_HI_RH_STEP);
+}
+/**
+ * grams of water in a cubic metre of air
+ * (tenths), from its vapour pressure e
+ * (1/50 Pa)
+ */
+inline int climate_abs_humidity(int temp10, long e){
+  //AH = 2.1674 * e(Pa) / T(K)
+  return 867L * e / (200L * (temp10 + 2732));
+}
+/**
+ * work out every result from a new reading.
+ * the vapour pressure is found once and
+ * shared by the dew point and absolute
+ * humidity.
+ */
+inline void climate_update(climate *result, int temp10, int rh10){
+  long e = climate_es_at(temp10) * constrain(rh10, 1, 1000) / 1000;
+  result->dew10 = climate_dew_point(e, &result->es_index);
+  result->heat10 = climate_heat_index(temp10, rh10);
+  result->abs10 = climate_abs_humidity(temp10, e);
+}
+
+#endif // CLIMATE_H
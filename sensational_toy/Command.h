@@ -0,0 +1,220 @@
+/*####################################################################
+ * FILE: Command.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Small binary request/response frames over Serial, so a host
+ *          can ask for readings, counters and statistics, or change
+ *          settings, while the device keeps logging. Frames are taken
+ *          a byte at a time as they arrive, nothing here waits.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: A request is
+ *          0xA5, command, length, payload (length bytes), check
+ *        and the answer
+ *          0x5A, command | 0x80, length, payload, check
+ *        check is the CRC-8 (_crc8_ccitt_update) of command, length
+ *        and payload. Numbers longer than a byte are sent most
+ *        significant byte first.
+ *
+ *        A request with a bad check byte, too long a payload, or not
+ *        finished within CMD_TIMEOUT_MS is dropped without an answer,
+ *        so the host should ask again if none comes. After a bad check
+ *        byte or length the bytes that follow are thrown away until
+ *        the next 0xA5, or until nothing has come for CMD_TIMEOUT_MS,
+ *        so the rest of a garbled request is never taken as text.
+ *        CMD_TIMEOUT_MS is well over one pass of the loop, since a
+ *        request can be split across two calls of poll_commands(). A request that
+ *        arrives whole but can't be carried out is answered with
+ *        CMD_ERROR, holding the command and one of the CMD_ERR_ values.
+ *
+ *        Bytes outside a frame are given back to the caller, so the
+ *        one letter text commands (see poll_commands()) still work.
+ *        None of them is 0xA5.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <inttypes.h>
+#include <util/crc16.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define CMD_START 0xA5 //first byte of a request
+#define CMD_ANSWER 0x5A //first byte of an answer
+#define CMD_ANSWER_BIT 0x80 //set in the command of an answer
+#define CMD_MAX_PAYLOAD 56
+#define CMD_TIMEOUT_MS 1000 //a request must arrive whole within this
+
+//commands, request payload -> answer payload
+#define CMD_GET_CHANNEL 0x01 //channel -> channel, value, fresh, age (s, 2 bytes)
+#define CMD_GET_COUNTERS 0x02 //none -> event overflows (2), log slots used (4), free (4),
+                              //then per DHT22: good, timeouts, checksums, stuck (2 each), failures
+#define CMD_GET_STATS 0x03 //channel -> channel, count (4), mean, deviation, average (x16, 2 each), flags
+#define CMD_SET_ALARM 0x04 //alarm, value (2) -> the same, once set
+#define CMD_EXPORT 0x05 //first slot (4), count -> first slot (4), count sent, the records
+#define CMD_GET_MEMORY 0x06 //none -> static, free, unused (2 each, see MemWatch.h)
+#define CMD_ERROR 0x7F //answer only: command, CMD_ERR_ value
+
+//CMD_ERROR reasons
+#define CMD_ERR_UNKNOWN 1 //no such command
+#define CMD_ERR_LENGTH 2 //payload is the wrong length for the command
+#define CMD_ERR_RANGE 3 //a channel, alarm or slot that doesn't exist
+
+//what command_feed() did with a byte
+#define CMD_TAKEN 0 //part of a request still arriving, or thrown away
+#define CMD_READY 1 //a whole request has arrived
+#define CMD_TEXT -1 //not part of a request
+
+/***************************
+ * COMMAND
+ ***************************/
+struct command
+{
+  uint8_t state; //which part of the request comes next
+  uint8_t cmd;
+  uint8_t len;
+  uint8_t got; //payload bytes so far
+  uint8_t crc;
+  unsigned long started; //millis() of the start byte, or of the last byte thrown away
+  uint8_t payload[CMD_MAX_PAYLOAD];
+};
+
+//command states
+#define CMD_IDLE 0
+#define CMD_CMD 1
+#define CMD_LEN 2
+#define CMD_PAYLOAD 3
+#define CMD_CHECK 4
+#define CMD_SKIP 5 //throwing bytes away after a bad request
+
+/***************************
+ * COMMAND FUNCTION(S)
+ *
+ * CONTENTS:
+ *   int command_feed(command*, uint8_t, unsigned long)
+ *   uint16_t command_word(command*, uint8_t)
+ *   unsigned long command_long(command*, uint8_t)
+ *   uint8_t command_put_word(uint8_t*, uint8_t, uint16_t)
+ *   uint8_t command_put_long(uint8_t*, uint8_t, unsigned long)
+ *   void command_answer(uint8_t, const uint8_t*, uint8_t)
+ *   void command_error(uint8_t, uint8_t)
+ ***************************/
+/**
+ * take the next byte from Serial, which came
+ * at now (millis()). returns CMD_READY once a
+ * whole request with a good check byte is in
+ * c, after which c can be read until the next
+ * call.
+ */
+int command_feed(command *c, uint8_t b, unsigned long now){
+  //a gap this long means whatever came before is over
+  if(c->state != CMD_IDLE && now - c->started > CMD_TIMEOUT_MS){
+    c->state = CMD_IDLE;
+  }
+  switch(c->state){
+  case CMD_SKIP:
+    //wait for the start of the next request
+    c->started = now;
+    if(b == CMD_START){
+      c->state = CMD_CMD;
+    }
+    break;
+  case CMD_IDLE:
+    if(b != CMD_START){
+      return CMD_TEXT;
+    }
+    c->started = now;
+    c->state = CMD_CMD;
+    break;
+  case CMD_CMD:
+    c->cmd = b;
+    c->crc = _crc8_ccitt_update(0, b);
+    c->state = CMD_LEN;
+    break;
+  case CMD_LEN:
+    if(b > CMD_MAX_PAYLOAD){
+      c->started = now;
+      c->state = CMD_SKIP;
+      break;
+    }
+    c->len = b;
+    c->got = 0;
+    c->crc = _crc8_ccitt_update(c->crc, b);
+    c->state = b ? CMD_PAYLOAD : CMD_CHECK;
+    break;
+  case CMD_PAYLOAD:
+    c->payload[c->got++] = b;
+    c->crc = _crc8_ccitt_update(c->crc, b);
+    if(c->got == c->len){
+      c->state = CMD_CHECK;
+    }
+    break;
+  case CMD_CHECK:
+    if(b == c->crc){
+      c->state = CMD_IDLE;
+      return CMD_READY;
+    }
+    c->started = now;
+    c->state = CMD_SKIP;
+    break;
+  }
+  return CMD_TAKEN;
+}
+/**
+ * two byte number from the payload
+ */
+inline uint16_t command_word(command *c, uint8_t at){
+  return (c->payload[at] << 8) | c->payload[at + 1];
+}
+/**
+ * four byte number from the payload
+ */
+inline unsigned long command_long(command *c, uint8_t at){
+  return ((unsigned long)command_word(c, at) << 16) | command_word(c, at + 2);
+}
+/**
+ * put a two byte number in an answer at n,
+ * returns where the next byte goes
+ */
+inline uint8_t command_put_word(uint8_t *out, uint8_t n, uint16_t value){
+  out[n] = value >> 8;
+  out[n + 1] = value & 0xFF;
+  return n + 2;
+}
+/**
+ * put a four byte number in an answer at n,
+ * returns where the next byte goes
+ */
+inline uint8_t command_put_long(uint8_t *out, uint8_t n, unsigned long value){
+  n = command_put_word(out, n, value >> 16);
+  return command_put_word(out, n, value & 0xFFFF);
+}
+/**
+ * send an answer to cmd
+ */
+void command_answer(uint8_t cmd, const uint8_t *payload, uint8_t len){
+  uint8_t crc = _crc8_ccitt_update(0, cmd | CMD_ANSWER_BIT);
+  crc = _crc8_ccitt_update(crc, len);
+  Serial.write(CMD_ANSWER);
+  Serial.write(cmd | CMD_ANSWER_BIT);
+  Serial.write(len);
+  for(uint8_t i = 0; i<len; i++){
+    Serial.write(payload[i]);
+    crc = _crc8_ccitt_update(crc, payload[i]);
+  }
+  Serial.write(crc);
+}
+/**
+ * tell the host cmd couldn't be carried out
+ */
+void command_error(uint8_t cmd, uint8_t reason){
+  uint8_t payload[2] = {cmd, reason};
+  command_answer(CMD_ERROR, payload, 2);
+}
+
+#endif // COMMAND_H
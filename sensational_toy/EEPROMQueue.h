@@ -0,0 +1,142 @@
+/*####################################################################
+ * FILE: EEPROMQueue.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Queued EEPROM writes, programmed in the background by the
+ *          EEPROM ready interrupt so the caller does not wait ~3.3 ms
+ *          per byte.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Writes are programmed in the order they were queued, and a
+ *        byte that already holds the value is skipped. Do not mix with
+ *        EEPROM.read()/write() unless flush() has been called first.
+ *
+ *        write() only waits when the queue is full, so it must hold
+ *        everything queued between two loops: EEPROM_QUEUE_SIZE - 1
+ *        bytes. R24U.h checks that the biggest mem_write() fits.
+ *
+ *        The queue lives in the sketch, so this header must only be
+ *        included from one file (the sketch) like the other headers in
+ *        this folder.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef EEPROMQUEUE_H
+#define EEPROMQUEUE_H
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define EEPROM_QUEUE_SIZE 64 //must be a power of two
+
+/***************************
+ * EEPROM QUEUE
+ ***************************/
+class EEPROMQueue
+{
+  public:
+    inline static void write(int, uint8_t);
+    // Queue a write, only waits if the queue is full
+
+    inline static uint8_t read(int);
+    // Read a byte, seeing any queued writes to it
+
+    inline static uint8_t pending();
+    // Number of queued writes not yet programmed
+
+    inline static void flush();
+    // Wait until every queued write has been programmed
+
+    inline static void service();
+    // Program the next queued write, called from the EEPROM ready interrupt
+
+  private:
+    static volatile uint16_t _addr[EEPROM_QUEUE_SIZE];
+    static volatile uint8_t _value[EEPROM_QUEUE_SIZE];
+    static volatile uint8_t _head;
+    static volatile uint8_t _tail;
+};
+
+EEPROMQueue eeprom_queue;
+
+volatile uint16_t EEPROMQueue::_addr[EEPROM_QUEUE_SIZE];
+volatile uint8_t EEPROMQueue::_value[EEPROM_QUEUE_SIZE];
+volatile uint8_t EEPROMQueue::_head = 0;
+volatile uint8_t EEPROMQueue::_tail = 0;
+
+void EEPROMQueue::write(int address, uint8_t value) {
+  uint8_t next = (_head + 1) & (EEPROM_QUEUE_SIZE - 1);
+  while (next == _tail)
+    ;
+  _addr[_head] = address;
+  _value[_head] = value;
+  _head = next;
+  EECR |= _BV(EERIE);
+}
+
+uint8_t EEPROMQueue::read(int address) {
+  uint8_t value;
+  uint8_t oldSREG;
+  for (;;) {
+    oldSREG = SREG;
+    cli();
+    // the newest queued write to this address wins
+    for (uint8_t i = _head; i != _tail; ) {
+      i = (i - 1) & (EEPROM_QUEUE_SIZE - 1);
+      if (_addr[i] == address) {
+        value = _value[i];
+        SREG = oldSREG;
+        return value;
+      }
+    }
+    // EEAR can't change while a byte is being programmed
+    if (!(EECR & _BV(EEPE)))
+      break;
+    SREG = oldSREG;
+  }
+  EEAR = address;
+  EECR |= _BV(EERE);
+  value = EEDR;
+  SREG = oldSREG;
+  return value;
+}
+
+uint8_t EEPROMQueue::pending() {
+  return (_head - _tail) & (EEPROM_QUEUE_SIZE - 1);
+}
+
+void EEPROMQueue::flush() {
+  while (pending() || (EECR & _BV(EEPE)))
+    ;
+}
+
+void EEPROMQueue::service() {
+  while (_tail != _head) {
+    uint16_t address = _addr[_tail];
+    uint8_t value = _value[_tail];
+    _tail = (_tail + 1) & (EEPROM_QUEUE_SIZE - 1);
+    EEAR = address;
+    EECR |= _BV(EERE);
+    if (EEDR != value) {
+      EEDR = value;
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);
+      return;
+    }
+  }
+  // nothing left to program
+  EECR &= ~_BV(EERIE);
+}
+
+// Runs whenever the EEPROM is ready and the queue has writes waiting
+ISR(EE_READY_vect) {
+  EEPROMQueue::service();
+}
+
+#endif // EEPROMQUEUE_H
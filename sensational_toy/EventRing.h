@@ -0,0 +1,108 @@
+/*####################################################################
+ * FILE: EventRing.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Hands events from an interrupt to loop() without either
+ *          side having to turn interrupts off. The interrupt pushes
+ *          onto the ring, the loop pops them off in batches.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Only one writer and one reader: a ring is filled by one
+ *        interrupt (or by the loop while that interrupt is off) and
+ *        emptied by the loop. Each side only moves its own index, and
+ *        an index is one byte so the AVR reads and writes it in one go.
+ *
+ *        SIZE must be a power of two, one slot is always left empty,
+ *        so a ring holds SIZE - 1 events. When it is full new events
+ *        are dropped and counted in overflows().
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef EVENTRING_H
+#define EVENTRING_H
+
+#include <inttypes.h>
+#include <util/atomic.h>
+
+//keeps the compiler from moving memory writes past this point,
+//so an event is whole before the index that hands it over moves
+#define EVENT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/***************************
+ * EVENTS
+ ***************************/
+#define EVENT_ECHO 1 //range finder echo, value is its length in us
+
+struct event
+{
+  uint8_t type; //EVENT_ value
+  uint8_t source; //pin or channel it came from
+  uint16_t value;
+};
+
+/***************************
+ * EVENT RING
+ ***************************/
+template<typename T, uint8_t SIZE>
+class EventRing
+{
+  static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "EventRing SIZE must be a power of two up to 128");
+
+  public:
+    EventRing() : _head(0), _tail(0), _overflows(0) {}
+
+    bool push(const T &item) {
+      // Writer side. Returns false, and counts it, if the ring is full
+      uint8_t head = _head;
+      uint8_t next = (head + 1) & (SIZE - 1);
+      if (next == _tail) {
+        if (_overflows < 0xFFFF)
+          _overflows++;
+        return false;
+      }
+      _items[head] = item;
+      EVENT_BARRIER();
+      _head = next;
+      return true;
+    }
+
+    bool pop(T &item) {
+      // Reader side. Returns false if the ring is empty
+      uint8_t tail = _tail;
+      if (tail == _head)
+        return false;
+      item = _items[tail];
+      EVENT_BARRIER();
+      _tail = (tail + 1) & (SIZE - 1);
+      return true;
+    }
+
+    uint8_t pop(T *items, uint8_t most) {
+      // Reader side. Takes up to most events at once, returns how many
+      uint8_t count = 0;
+      while (count < most && pop(items[count]))
+        count++;
+      return count;
+    }
+
+    uint8_t count() {
+      return (_head - _tail) & (SIZE - 1);
+    }
+
+    uint16_t overflows() {
+      // two bytes, so read with interrupts off
+      uint16_t overflows;
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { overflows = _overflows; }
+      return overflows;
+    }
+
+  private:
+    volatile uint8_t _head; //next slot to write, only moved by the writer
+    volatile uint8_t _tail; //next slot to read, only moved by the reader
+    T _items[SIZE];
+    volatile uint16_t _overflows;
+};
+
+#endif // EVENTRING_H
@@ -0,0 +1,173 @@
+/*####################################################################
+ * FILE: FastPin.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Pin access that is worked out when the sketch is compiled.
+ *          digitalWrite() looks the pin's port up in tables and checks
+ *          for PWM every call. FastPin<pin> turns an Arduino pin number
+ *          straight into its port register and bit, so setting or
+ *          clearing it is a single sbi/cbi instruction.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: FastPin<pin>        one pin known when compiling
+ *        FastPins<pins...>   several pins, the pins on each port
+ *                            change together in one write
+ *        FastPinRef          a pin only known while running (set by
+ *                            a setter function), looked up once
+ *
+ *        Versalino bus pins can be used through versalinoPin() in
+ *        Versalino.h, e.g. FastPin<versalinoPin(BUSA, D1)>
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+#else
+  #include "WProgram.h"
+  #include <pins_arduino.h>
+#endif
+
+#include <util/atomic.h>
+
+/***************************
+ * PIN TABLES
+ * port letter and bit for each
+ * Arduino pin number
+ ***************************/
+#if defined(__AVR_ATmega32U4__)
+//Leonardo
+static constexpr char FASTPIN_PORT[] = {
+  'D','D','D','D','D','C','D','E','B','B','B','B','D','C', //D0 - D13
+  'B','B','B','B',                                         //MISO, SCK, MOSI, SS
+  'F','F','F','F','F','F'                                  //A0 - A5
+};
+static constexpr uint8_t FASTPIN_BIT[] = {
+  2,3,1,0,4,6,7,6,4,5,6,7,6,7,
+  3,1,2,0,
+  7,6,5,4,1,0
+};
+#else
+//Uno, Versalino and other ATmega328 boards
+static constexpr char FASTPIN_PORT[] = {
+  'D','D','D','D','D','D','D','D', //D0 - D7
+  'B','B','B','B','B','B',         //D8 - D13
+  'C','C','C','C','C','C'          //A0 - A5
+};
+static constexpr uint8_t FASTPIN_BIT[] = {
+  0,1,2,3,4,5,6,7,
+  0,1,2,3,4,5,
+  0,1,2,3,4,5
+};
+#endif
+
+/***************************
+ * PORT REGISTERS
+ ***************************/
+template<char PORT> struct FastPort;
+
+#define FASTPIN_DEFINE_PORT(C, L) \
+  template<> struct FastPort<C> { \
+    static inline volatile uint8_t &out() { return PORT##L; } \
+    static inline volatile uint8_t &ddr() { return DDR##L; } \
+    static inline volatile uint8_t &in() { return PIN##L; } \
+  };
+
+FASTPIN_DEFINE_PORT('B', B)
+FASTPIN_DEFINE_PORT('C', C)
+FASTPIN_DEFINE_PORT('D', D)
+#if defined(__AVR_ATmega32U4__)
+FASTPIN_DEFINE_PORT('E', E)
+FASTPIN_DEFINE_PORT('F', F)
+#endif
+
+/***************************
+ * SINGLE PIN
+ ***************************/
+template<uint8_t PIN>
+struct FastPin
+{
+  typedef FastPort<FASTPIN_PORT[PIN]> Port;
+  static const uint8_t mask = 1 << FASTPIN_BIT[PIN];
+
+  static inline void high() { Port::out() |= mask; }
+  static inline void low() { Port::out() &= ~mask; }
+  static inline void write(uint8_t value) { if (value) high(); else low(); }
+  static inline void toggle() { Port::in() = mask; } // writing PINx flips the output
+  static inline uint8_t read() { return (Port::in() & mask) != 0; }
+  static inline void output() { Port::ddr() |= mask; }
+  static inline void input() { Port::ddr() &= ~mask; }
+};
+
+/***************************
+ * PIN GROUP
+ * pins on the same port change in one
+ * write with interrupts held off, so
+ * nothing sees them half changed
+ ***************************/
+template<uint8_t... PINS> struct FastPins;
+
+template<>
+struct FastPins<>
+{
+  static constexpr uint8_t mask(char) { return 0; }
+};
+
+template<uint8_t PIN, uint8_t... REST>
+struct FastPins<PIN, REST...>
+{
+  // bits of the group that are on a port
+  static constexpr uint8_t mask(char port) {
+    return (FASTPIN_PORT[PIN] == port ? (1 << FASTPIN_BIT[PIN]) : 0) | FastPins<REST...>::mask(port);
+  }
+
+  static inline void high() { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { each<Set>(); } }
+  static inline void low() { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { each<Clear>(); } }
+  static inline void output() { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { each<Output>(); } }
+
+  private:
+    struct Set { template<char P> static inline void apply() { FastPort<P>::out() |= mask(P); } };
+    struct Clear { template<char P> static inline void apply() { FastPort<P>::out() &= ~mask(P); } };
+    struct Output { template<char P> static inline void apply() { FastPort<P>::ddr() |= mask(P); } };
+
+    // ports the group has no pins on drop out when compiled
+    template<class OP> static inline void each() {
+      if (mask('B')) OP::template apply<'B'>();
+      if (mask('C')) OP::template apply<'C'>();
+      if (mask('D')) OP::template apply<'D'>();
+#if defined(__AVR_ATmega32U4__)
+      if (mask('E')) OP::template apply<'E'>();
+      if (mask('F')) OP::template apply<'F'>();
+#endif
+    }
+};
+
+/***************************
+ * RUNTIME PIN
+ * for pins chosen by a setter, the
+ * register and bit are looked up once
+ * in attach() instead of every write
+ ***************************/
+struct FastPinRef
+{
+  volatile uint8_t *out;
+  volatile uint8_t *in;
+  uint8_t mask;
+
+  void attach(uint8_t pin) {
+    uint8_t port = digitalPinToPort(pin);
+    out = portOutputRegister(port);
+    in = portInputRegister(port);
+    mask = digitalPinToBitMask(pin);
+  }
+  // single bit changes are not atomic through a pointer, so hold interrupts off
+  inline void high() { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { *out |= mask; } }
+  inline void low() { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { *out &= ~mask; } }
+  inline uint8_t read() { return (*in & mask) != 0; }
+};
+
+#endif // FASTPIN_H
@@ -0,0 +1,171 @@
+/*####################################################################
+ * FILE: LedFx.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Background LED effects. Fades and blinks run from the
+ *          timer 0 compare B interrupt (timer 0 already ticks every
+ *          ~1 ms for millis()), so they keep their speed no matter
+ *          what the main loop is doing. The loop only posts which
+ *          effect a channel should show.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Each channel has an output function that is handed a
+ *        brightness of 0 - 255. It is called from the interrupt,
+ *        and only when the brightness changes, so keep it short.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef LEDFX_H
+#define LEDFX_H
+
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define LED_FX_CHANNELS 2
+#define LED_FX_DIVIDER 10 //timer 0 interrupts per effect step
+#define LED_FX_STEP_MS 10 //about how long one effect step takes
+
+//effects
+#define FX_OFF 0
+#define FX_ON 1
+#define FX_BLINK 2 //on for the first half of the period, off for the second
+#define FX_FADE 3 //fade in then out over the period
+
+//gamma corrected brightness, so equal steps look equal to the eye
+const uint8_t led_gamma[256] PROGMEM = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+    2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+    5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+   10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+   17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+   25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+   37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+   51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+   69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+   90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+  115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+  144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+  177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+  215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255
+};
+
+/***************************
+ * EFFECT VARIABLES
+ ***************************/
+typedef void (*led_fx_output)(uint8_t);
+
+struct led_fx_channel {
+  led_fx_output out;
+  volatile uint8_t effect;
+  volatile uint16_t period; //effect steps in one cycle
+  uint16_t step; //position in the cycle
+  int level; //last brightness sent, -1 to force the next one out
+};
+
+//per thread in host builds, see R24U.h
+#ifndef R24U_LOCAL
+#define R24U_LOCAL
+#endif
+
+R24U_LOCAL led_fx_channel led_fx_channels[LED_FX_CHANNELS];
+R24U_LOCAL uint8_t led_fx_divider = 0;
+
+/***************************
+ * EFFECT FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void led_fx_begin()
+ *   void led_fx_attach(int, led_fx_output)
+ *   void led_fx(int, int, unsigned int)
+ *   uint8_t led_fx_level(led_fx_channel&)
+ ***************************/
+/**
+ * start the effect interrupt. timer 0 is left
+ * running as it is, compare B only adds an
+ * interrupt part way through each count.
+ */
+void led_fx_begin(){
+  OCR0B = 0x80;
+  TIMSK0 |= _BV(OCIE0B);
+}
+/**
+ * set the function that shows a channel's brightness
+ */
+void led_fx_attach(int channel, led_fx_output out){
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    led_fx_channels[channel].out = out;
+    led_fx_channels[channel].effect = FX_OFF;
+    led_fx_channels[channel].period = 1;
+    led_fx_channels[channel].level = -1;
+  }
+}
+/**
+ * post an effect for a channel. posting the
+ * effect it already shows does nothing, so this
+ * can be called on every pass of the loop.
+ */
+void led_fx(int channel, int effect, unsigned int period_ms){
+  led_fx_channel &ch = led_fx_channels[channel];
+  unsigned int period = max(period_ms / LED_FX_STEP_MS, 2U);
+  if(ch.effect == effect && ch.period == period){
+    return;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+    ch.effect = effect;
+    ch.period = period;
+    ch.step = 0;
+    ch.level = -1;
+  }
+}
+/**
+ * brightness for a channel's current step
+ */
+uint8_t led_fx_level(led_fx_channel &ch){
+  switch(ch.effect){
+  case FX_ON:
+    return 255;
+  case FX_BLINK:
+    return ch.step < ch.period/2 ? 255 : 0;
+  case FX_FADE: {
+    //triangle wave 0 - 255 - 0 over the period
+    unsigned int pos = (unsigned long)ch.step * 510 / ch.period;
+    if(pos > 255){
+      pos = 510 - pos;
+    }
+    return pgm_read_byte(&led_gamma[pos]);
+  }
+  default:
+    return 0;
+  }
+}
+
+ISR(TIMER0_COMPB_vect){
+  if(++led_fx_divider < LED_FX_DIVIDER){
+    return;
+  }
+  led_fx_divider = 0;
+  for(int i = 0; i<LED_FX_CHANNELS; i++){
+    led_fx_channel &ch = led_fx_channels[i];
+    if(!ch.out){
+      continue;
+    }
+    uint8_t level = led_fx_level(ch);
+    ch.step = ch.step + 1;
+    if(ch.step >= ch.period){
+      ch.step = 0;
+    }
+    if(level != ch.level){
+      ch.level = level;
+      ch.out(level);
+    }
+  }
+}
+
+#endif // LEDFX_H
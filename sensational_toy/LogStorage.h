@@ -0,0 +1,271 @@
+/*####################################################################
+ * FILE: LogStorage.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Storage the sensor log is written through. The log only
+ *          sees a flat run of bytes, so the same code records to the
+ *          internal EEPROM, an external SPI NOR flash chip or (when
+ *          built on a computer for testing) a plain file.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: A byte may only be written after the area holding it has
+ *        been erased (set to LOG_BLANK). blockSize() tells the log
+ *        how much erase() clears at once: 1 for EEPROM, a whole
+ *        sector for flash.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef LOGSTORAGE_H
+#define LOGSTORAGE_H
+
+#include <inttypes.h>
+
+#define LOG_BLANK 0xFF //value of an erased byte
+#define EEPROM_RESERVED 32 //bytes at the end of the EEPROM kept for the watchdog trace (see LoopWatch.h)
+
+class LogStorage
+{
+  public:
+    virtual uint32_t size() = 0;
+    // Number of bytes available
+
+    virtual uint16_t blockSize() = 0;
+    // Smallest area erase() clears
+
+    virtual uint8_t read(uint32_t address) = 0;
+    // Read a byte, including any that are still buffered
+
+    virtual void write(uint32_t address, uint8_t value) = 0;
+    // Write a byte that has been erased
+
+    virtual void erase(uint32_t from, uint32_t to) = 0;
+    // Set every byte in [from, to) to LOG_BLANK, growing the range
+    // out to whole blocks
+
+    virtual void sync() = 0;
+    // Send buffered writes on to the device
+
+    virtual bool busy() { return false; }
+    // True while earlier writes are still being programmed in the
+    // background, so more writes now would have to wait
+};
+
+#if defined(ARDUINO)
+
+#include "EEPROMQueue.h"
+#include "SPI.h"
+
+/***************************
+ * INTERNAL EEPROM
+ ***************************/
+class EEPROMStorage : public LogStorage
+{
+  public:
+    uint32_t size() { return E2END + 1 - EEPROM_RESERVED; }
+    uint16_t blockSize() { return 1; }
+    uint8_t read(uint32_t address) { return eeprom_queue.read(address); }
+    void write(uint32_t address, uint8_t value) { eeprom_queue.write(address, value); }
+    // eeprom_queue.write() already skips bytes that hold the value
+    void erase(uint32_t from, uint32_t to) {
+      for (uint32_t i = from; i < to; i++)
+        eeprom_queue.write(i, LOG_BLANK);
+    }
+    // the write queue drains in the background
+    void sync() {}
+    bool busy() { return eeprom_queue.pending() != 0; }
+};
+
+/***************************
+ * SPI NOR FLASH
+ * Shares MOSI, MISO and SCK with the
+ * bargraph, only needs its own
+ * chip select pin. The bargraph's LAT
+ * is wired to MOSI, so every flash
+ * access changes what it shows until
+ * its next update, unless LAT is moved
+ * to a pin of its own and passed to
+ * set_bargraph_latch() (R24U.h) before
+ * setup_bargraph().
+ ***************************/
+#define FLASH_PAGE_SIZE 256
+#define FLASH_SECTOR_SIZE 4096
+#define FLASH_BUFFER_SIZE 32 //bytes gathered before a page program, at most FLASH_PAGE_SIZE
+
+#define FLASH_READ 0x03
+#define FLASH_PAGE_PROGRAM 0x02
+#define FLASH_WRITE_ENABLE 0x06
+#define FLASH_READ_STATUS 0x05
+#define FLASH_SECTOR_ERASE 0x20
+#define FLASH_JEDEC_ID 0x9F
+#define FLASH_BUSY 0x01
+
+class SPIFlashStorage : public LogStorage
+{
+  public:
+    SPIFlashStorage(uint8_t csPin, uint32_t bytes) :
+      _cs(csPin), _size(bytes), _bufferLen(0) {}
+
+    boolean begin() {
+      // Set up the chip select and check a chip answers.
+      // Returns false if nothing is connected
+      pinMode(_cs, OUTPUT);
+      digitalWrite(_cs, HIGH);
+      SPI.begin();
+      select();
+      SPI.transfer(FLASH_JEDEC_ID);
+      uint8_t maker = SPI.transfer(0);
+      deselect();
+      return maker != 0x00 && maker != 0xFF;
+    }
+
+    uint32_t size() { return _size; }
+    uint16_t blockSize() { return FLASH_SECTOR_SIZE; }
+
+    uint8_t read(uint32_t address) {
+      if (address >= _bufferAddr && address < _bufferAddr + _bufferLen)
+        return _buffer[address - _bufferAddr];
+      waitReady();
+      select();
+      command(FLASH_READ, address);
+      uint8_t value = SPI.transfer(0);
+      deselect();
+      return value;
+    }
+
+    void write(uint32_t address, uint8_t value) {
+      // writes are gathered while they run on from each other
+      // inside one page, then programmed together
+      if (_bufferLen && (address != _bufferAddr + _bufferLen
+          || _bufferLen == FLASH_BUFFER_SIZE
+          || address % FLASH_PAGE_SIZE == 0))
+        sync();
+      if (!_bufferLen)
+        _bufferAddr = address;
+      _buffer[_bufferLen++] = value;
+    }
+
+    // a sector erase takes up to 400 ms, so the last one is left
+    // running; anything that needs the chip waits for it first
+    void erase(uint32_t from, uint32_t to) {
+      sync();
+      if (from >= to)
+        return;
+      for (uint32_t sector = from - from % FLASH_SECTOR_SIZE; sector < to; sector += FLASH_SECTOR_SIZE) {
+        waitReady();
+        writeEnable();
+        select();
+        command(FLASH_SECTOR_ERASE, sector);
+        deselect();
+      }
+    }
+
+    // the page program is left running like an erase
+    void sync() {
+      if (!_bufferLen)
+        return;
+      waitReady();
+      writeEnable();
+      select();
+      command(FLASH_PAGE_PROGRAM, _bufferAddr);
+      for (uint8_t i = 0; i < _bufferLen; i++)
+        SPI.transfer(_buffer[i]);
+      deselect();
+      _bufferLen = 0;
+    }
+
+    bool busy() {
+      select();
+      SPI.transfer(FLASH_READ_STATUS);
+      bool busy = SPI.transfer(0) & FLASH_BUSY;
+      deselect();
+      return busy;
+    }
+
+  private:
+    void select() { digitalWrite(_cs, LOW); }
+    void deselect() { digitalWrite(_cs, HIGH); }
+
+    void command(uint8_t cmd, uint32_t address) {
+      SPI.transfer(cmd);
+      SPI.transfer(address >> 16);
+      SPI.transfer(address >> 8);
+      SPI.transfer(address);
+    }
+
+    void writeEnable() {
+      select();
+      SPI.transfer(FLASH_WRITE_ENABLE);
+      deselect();
+    }
+
+    void waitReady() {
+      select();
+      SPI.transfer(FLASH_READ_STATUS);
+      while (SPI.transfer(0) & FLASH_BUSY)
+        ;
+      deselect();
+    }
+
+    uint8_t _cs;
+    uint32_t _size;
+    uint8_t _buffer[FLASH_BUFFER_SIZE];
+    uint32_t _bufferAddr;
+    uint8_t _bufferLen;
+};
+
+#endif
+
+#if !defined(__AVR__)
+
+#include <stdio.h>
+
+/***************************
+ * HOST FILE
+ * Used when the log code is built on
+ * a computer, e.g. by tools/log_check.cpp.
+ ***************************/
+class FileStorage final : public LogStorage
+{
+  public:
+    FileStorage(const char *path, uint32_t bytes) : _size(bytes) {
+      _file = fopen(path, "r+b");
+      if (!_file) {
+        // a new file starts out erased
+        _file = fopen(path, "w+b");
+        erase(0, bytes);
+      }
+    }
+    ~FileStorage() { if (_file) fclose(_file); }
+
+    uint32_t size() { return _size; }
+    uint16_t blockSize() { return 1; }
+
+    uint8_t read(uint32_t address) {
+      fseek(_file, address, SEEK_SET);
+      int value = fgetc(_file);
+      return value == EOF ? LOG_BLANK : value;
+    }
+
+    void write(uint32_t address, uint8_t value) {
+      fseek(_file, address, SEEK_SET);
+      fputc(value, _file);
+    }
+
+    void erase(uint32_t from, uint32_t to) {
+      fseek(_file, from, SEEK_SET);
+      for (uint32_t i = from; i < to; i++)
+        fputc(LOG_BLANK, _file);
+    }
+
+    void sync() { fflush(_file); }
+
+  private:
+    FILE *_file;
+    uint32_t _size;
+};
+
+#endif
+
+#endif // LOGSTORAGE_H
@@ -0,0 +1,181 @@
+/*####################################################################
+ * FILE: LoopWatch.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Catches the main loop getting stuck. The watchdog timer
+ *          restarts the board if loop() doesn't come round within
+ *          WATCH_TIMEOUT. Just before it does, its interrupt saves how
+ *          long the last few loops took and which part of the loop was
+ *          running, so the hang can be looked into after the fact.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: The trace is kept in the last EEPROM_RESERVED bytes of the
+ *        EEPROM, which the log leaves alone (see LogStorage.h). It is
+ *        sent at the next Serial connection as one line:
+ *          !task,stuck,d0,d1,...,d7
+ *        task is the WATCH_ value of the part that hung, stuck how
+ *        many ms it had been running, and d0 - d7 how long the last
+ *        loops took in ms, oldest first.
+ *
+ *        Outside the watchdog interrupt the trace is read and
+ *        cleared through eeprom_queue (EEPROMQueue.h), as the log
+ *        is, so neither races the queue's interrupt for the EEPROM.
+ *
+ *        Anything that waits on purpose for longer than WATCH_TIMEOUT
+ *        must call watch_feed() while it waits.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef LOOPWATCH_H
+#define LOOPWATCH_H
+
+#include <avr/wdt.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#include "LogStorage.h"
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define WATCH_TIMEOUT WDTO_4S //longest pulseIn() wait (echo pin without an interrupt) is 1 s
+#define WATCH_RING 8 //loop times kept
+#define WATCH_MAGIC 0xA5 //first byte of a saved trace
+#define WATCH_ADDRESS (E2END + 1 - EEPROM_RESERVED)
+#define WATCH_TRACE_SIZE (4 + 2*WATCH_RING) //magic, task, stuck (2), loop times, then the check byte
+
+//parts of the loop, see watch_task()
+#define WATCH_LOOP 0
+#define WATCH_SENSORS 1
+#define WATCH_BARGRAPH 2
+#define WATCH_C0 3
+#define WATCH_RANGE 4
+#define WATCH_LOG_WRITE 5
+#define WATCH_LOG_READ 6
+#define WATCH_TIMER 7
+#define WATCH_DELAY 8
+#define WATCH_EVENTS 9
+#define WATCH_COMMANDS 10
+#define WATCH_LOG_CLEAR 11
+
+/***************************
+ * WATCH VARIABLES
+ ***************************/
+volatile uint8_t watch_current = WATCH_LOOP; //part of the loop running now
+unsigned int watch_ring[WATCH_RING]; //ms each of the last loops took
+uint8_t watch_next = 0; //where the next loop time goes in the ring
+unsigned long watch_loop_start = 0;
+uint8_t watch_saved = 0; //a trace from before the last restart is waiting to be sent
+
+/***************************
+ * WATCH FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void watch_begin()
+ *   void watch_loop()
+ *   void watch_task(uint8_t)
+ *   void watch_feed()
+ *   void watch_report()
+ ***************************/
+/**
+ * note whether the board was restarted by the
+ * watchdog and start watching
+ *
+ * used in Setup();
+ */
+void watch_begin(){
+  watch_saved = eeprom_queue.read(WATCH_ADDRESS) == WATCH_MAGIC;
+  watch_loop_start = millis();
+  wdt_enable(WATCH_TIMEOUT);
+  //call the interrupt first, the restart follows if it returns
+  WDTCSR |= _BV(WDIE);
+}
+/**
+ * call at the start of every loop(). times the
+ * loop that just finished and restarts the
+ * watchdog's count.
+ */
+void watch_loop(){
+  unsigned long now = millis();
+  watch_ring[watch_next] = min(now - watch_loop_start, 0xFFFFUL);
+  watch_next = (watch_next + 1) % WATCH_RING;
+  watch_loop_start = now;
+  watch_current = WATCH_LOOP;
+  wdt_reset();
+}
+/**
+ * mark which part of the loop is running,
+ * it is saved if the loop hangs there
+ */
+inline void watch_task(uint8_t task){
+  watch_current = task;
+}
+/**
+ * for waits that are meant to be long
+ */
+inline void watch_feed(){
+  wdt_reset();
+}
+/**
+ * send the trace saved before the last
+ * restart, if there is one, and forget it
+ */
+void watch_report(){
+  if(!watch_saved){
+    return;
+  }
+  uint8_t trace[WATCH_TRACE_SIZE + 1];
+  uint8_t crc = 0;
+  for(uint8_t i = 0; i<=WATCH_TRACE_SIZE; i++){
+    trace[i] = eeprom_queue.read(WATCH_ADDRESS + i);
+    if(i < WATCH_TRACE_SIZE){
+      crc = _crc8_ccitt_update(crc, trace[i]);
+    }
+  }
+  if(crc == trace[WATCH_TRACE_SIZE]){
+    Serial.print('!');
+    Serial.print(trace[1]);
+    Serial.print(',');
+    Serial.print((unsigned int)(trace[2] | (trace[3] << 8)));
+    for(uint8_t i = 0; i<WATCH_RING; i++){
+      Serial.print(',');
+      Serial.print((unsigned int)(trace[4 + 2*i] | (trace[5 + 2*i] << 8)));
+    }
+    Serial.println();
+  }
+  eeprom_queue.write(WATCH_ADDRESS, LOG_BLANK);
+  watch_saved = 0;
+}
+/**
+ * the loop has hung. the EEPROM write queue is
+ * stopped, since it can't run from in here, any
+ * write it had started is let finish, and the
+ * trace is written straight to the EEPROM. then
+ * wait for the restart.
+ */
+ISR(WDT_vect){
+  EECR &= ~_BV(EERIE);
+  unsigned int stuck = min(millis() - watch_loop_start, 0xFFFFUL);
+  uint8_t trace[WATCH_TRACE_SIZE];
+  trace[0] = WATCH_MAGIC;
+  trace[1] = watch_current;
+  trace[2] = stuck & 0xFF;
+  trace[3] = stuck >> 8;
+  for(uint8_t i = 0; i<WATCH_RING; i++){
+    unsigned int took = watch_ring[(watch_next + i) % WATCH_RING];
+    trace[4 + 2*i] = took & 0xFF;
+    trace[5 + 2*i] = took >> 8;
+  }
+  uint8_t crc = 0;
+  for(uint8_t i = 0; i<WATCH_TRACE_SIZE; i++){
+    crc = _crc8_ccitt_update(crc, trace[i]);
+    eeprom_write_byte((uint8_t*)(WATCH_ADDRESS + i), trace[i]);
+  }
+  eeprom_write_byte((uint8_t*)(WATCH_ADDRESS + WATCH_TRACE_SIZE), crc);
+  eeprom_busy_wait();
+  while(1);
+}
+
+#endif // LOOPWATCH_H
@@ -0,0 +1,150 @@
+/*####################################################################
+ * FILE: MemWatch.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Keeps an eye on the Leonardo's 2.5 KB of SRAM. The stack is
+ *          painted at startup so the deepest it has ever gone can be
+ *          found later, and the free memory can be asked for over
+ *          Serial while the sketch runs.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: SRAM from the bottom up holds the globals (.data and .bss),
+ *        then the heap, then the gap the stack grows down into from
+ *        the top. The only thing on the heap is the bargraph's
+ *        canvas, which SFEbarGraph::begin() mallocs in
+ *        setup_bargraph() (4 bytes a board, plus malloc's 2). Before
+ *        the sketch starts every byte past the globals is set to
+ *        STACK_PAINT. Bytes above the heap still holding it were
+ *        never reached by the stack, so stack_unused() is how close
+ *        it has come to the heap.
+ *
+ *        An "M" sent over Serial (see text_command()) is answered
+ *        with one line:
+ *          Mstatic,heap,free,unused
+ *        static is the bytes taken by globals, heap the bytes on the
+ *        heap, free the bytes between the heap and the stack right
+ *        now and unused the smallest that gap has ever been.
+ *
+ *        tools/ram_report.sh lists which file the globals come from
+ *        and checks the globals and the heap leave room for the
+ *        stack. It isn't part of the build, run it by hand on the
+ *        built .elf.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef MEMWATCH_H
+#define MEMWATCH_H
+
+#include <avr/io.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define STACK_PAINT 0xC5 //unlikely to be pushed by chance
+
+#if defined(__AVR__)
+
+/***************************
+ * LINKER SYMBOLS
+ ***************************/
+extern uint8_t __data_start; //first global
+extern uint8_t __heap_start; //just past the last global
+extern void *__brkval; //top of the heap, 0 while nothing is on it
+
+/***************************
+ * MEMORY FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void stack_paint()
+ *   unsigned int static_memory()
+ *   unsigned int heap_memory()
+ *   unsigned int free_memory()
+ *   unsigned int stack_unused()
+ *   void print_memory()
+ ***************************/
+/**
+ * runs before the globals are set up, so it
+ * can't use any and must not touch r1, which
+ * isn't zero yet. paints from the end of the
+ * globals to the top of RAM.
+ */
+void stack_paint(void) __attribute__((naked, used, section(".init1")));
+void stack_paint(void){
+  __asm__ __volatile__(
+    "    ldi r30, lo8(__heap_start)\n"
+    "    ldi r31, hi8(__heap_start)\n"
+    "    ldi r24, %0\n"
+    "    ldi r25, hi8(%1)\n"
+    "    rjmp 2f\n"
+    "1:  st Z+, r24\n"
+    "2:  cpi r30, lo8(%1)\n"
+    "    cpc r31, r25\n"
+    "    brlo 1b\n"
+    "    breq 1b\n"
+    :: "M" (STACK_PAINT), "i" (RAMEND)
+  );
+}
+/**
+ * bytes taken by globals
+ */
+unsigned int static_memory(){
+  return &__heap_start - &__data_start;
+}
+/**
+ * bytes taken by the heap, malloc's
+ * bookkeeping included
+ */
+unsigned int heap_memory(){
+  return __brkval ? (uint8_t*)__brkval - &__heap_start : 0;
+}
+/**
+ * bytes between the top of the heap and the
+ * stack at the moment
+ */
+unsigned int free_memory(){
+  uint8_t *heap_end = __brkval ? (uint8_t*)__brkval : &__heap_start;
+  return (uint8_t*)SP - heap_end;
+}
+/**
+ * bytes the stack has never reached since
+ * startup. counts the paint up from the top
+ * of the heap, so a heap that has grown into
+ * the paint is left out.
+ */
+unsigned int stack_unused(){
+  const uint8_t *p = __brkval ? (const uint8_t*)__brkval : &__heap_start;
+  unsigned int unused = 0;
+  while(*p == STACK_PAINT && p <= (const uint8_t*)SP){
+    unused++;
+    p++;
+  }
+  return unused;
+}
+
+#else
+
+//a computer has no SRAM map to watch (see tools/host/Arduino.h)
+unsigned int static_memory(){ return 0; }
+unsigned int heap_memory(){ return 0; }
+unsigned int free_memory(){ return 0; }
+unsigned int stack_unused(){ return 0; }
+
+#endif
+
+/**
+ * send the memory line (see NOTES)
+ */
+void print_memory(){
+  Serial.print('M');
+  Serial.print(static_memory());
+  Serial.print(',');
+  Serial.print(heap_memory());
+  Serial.print(',');
+  Serial.print(free_memory());
+  Serial.print(',');
+  Serial.println(stack_unused());
+}
+
+#endif // MEMWATCH_H
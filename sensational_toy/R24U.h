@@ -38,11 +38,83 @@
 //MEMORY MANIPULATION
 #define READ 0
 #define WRITE 1
-#define CONTROLBIT 512
-#define ADDRESSBIT 511
+#define LOG_HEADER_SIZE 4 //sequence start, flags and check byte
+#define LOG_CLEARING 0x01 //header flag: a reset was cut short, finish clearing
+
+//LOG RECORDS
+//every record is four bytes: a header, a data byte, the low
+//byte of its sequence number and a check byte.
+//a sample header holds the seconds since the previous record,
+//an anchor is ANCHOR_BYTES records each holding one byte of
+//the full time so the host can rebuild absolute time.
+#define REC_SIZE 4
+#define REC_ANCHOR 0x80 //header flag: record is part of an anchor
+#define REC_SYNCED 0x40 //anchor flag: time came from the host (else uptime)
+#define REC_PART 0x03 //anchor: which byte of the time (0 is the most significant)
+#define REC_CHANNEL 0x20 //with REC_ANCHOR: another channel, read with the record before
+#define REC_CHANNEL_MASK 0x1F
+#define REC_MAX_DELTA 0x7F //longest gap (in seconds) a sample header can hold
+#define ANCHOR_BYTES 4
+#define ANCHOR_PERIOD 32 //samples written between anchors
+#define CLEAR_CHUNK 3 //record slots cleared per loop (see clear_step())
+#define READ_CHUNK 8 //records sent to the host per loop (see read_step())
+
+//EVENTS (see EventRing.h)
+#define EVENT_RING_SIZE 16
+#define EVENT_BATCH 4 //events handled per loop
+
+//COMMANDS (see Command.h)
+#define CMD_MAX_BYTES 64 //Serial bytes handled per loop
+#define EXPORT_MAX_RECORDS 12 //records sent in one CMD_EXPORT answer
+
+//alarms CMD_SET_ALARM can change
+#define ALARM_HUMIDITY 0 //set_humidity_alarm()
+#define ALARM_RANGE 1 //set_range_alarm()
+#define ALARM_DEW 2 //set_dew_alarm()
+#define ALARM_HEAT 3 //set_heat_alarm()
+
+//RANGE FINDER
+#define RANGE_PERIOD_MS 60 //shortest time between pings, so old echoes die out
+#define RANGE_TIMEOUT_MS 100 //give up on an echo after this long
+#define RANGE_TRIGGER_US 10
+
+#ifndef NOT_AN_INTERRUPT
+#define NOT_AN_INTERRUPT -1
+#endif
+#ifndef digitalPinToInterrupt
+//cores before 1.6 don't have it, this is the Leonardo's numbering
+#define digitalPinToInterrupt(p) ((p) == 3 ? 0 : (p) == 2 ? 1 : (p) == 0 ? 2 : (p) == 1 ? 3 : (p) == 7 ? 4 : NOT_AN_INTERRUPT)
+#endif
 
 #define NULLTERM '\0'
 
+//state that is per thread in host builds (see tools/host/Arduino.h),
+//so each thread can run devices of its own. empty on the board
+#ifndef R24U_LOCAL
+#define R24U_LOCAL
+#endif
+
+//SENSOR ARRAY
+#define MAX_DHT_SENSORS 4
+#define MAX_ANALOG_SENSORS 4
+#define MAX_CHANNELS 8 //log channels, channel 0 is the first humidity sensor
+#define MAX_CLIMATE_CHANNELS 4
+//a channel whose sensor hasn't read well for this long is not saved
+#define CHANNEL_STALE_MS ((DHT22_RETRIES + 1) * (unsigned long)DHT22_PERIOD_MS)
+
+//a clear_step() and the biggest mem_write() right after it must
+//fit the EEPROM write queue, or the loop waits on it
+static_assert((CLEAR_CHUNK + ANCHOR_BYTES + MAX_CHANNELS) * REC_SIZE < EEPROM_QUEUE_SIZE, "EEPROM_QUEUE_SIZE is too small");
+
+//CLIMATE RESULTS (see Climate.h), for add_climate_channel()
+#define CLIMATE_DEW 0 //dew point
+#define CLIMATE_HEAT 1 //heat index
+#define CLIMATE_ABS 2 //absolute humidity
+
+//LED EFFECT CHANNELS (see LedFx.h)
+#define LED_MEMORY 0
+#define LED_RGB 1
+
 /*#################################
  #
  #     FUNCTION PROTOTYPES
@@ -50,18 +122,27 @@
  #
  #################################*/
 
+//DEVICE SETTER
+void set_device(struct device*);
+
 //PIN SETTERS
 void set_range_pins(int, int);
 void set_humidity_pins(int); 
+void set_bargraph_latch(int);
 
 //ALARM SETTERS
 void set_humidity_alarm(int);
 void set_range_alarm(int);
 void set_mem_full_led(int);
+void set_dew_alarm(int);
+void set_heat_alarm(int);
+void set_anomaly_alarm(int, int);
 
 //TIMER SETTERS
 void set_global_delay(double);
 void set_rom_sensor_delay(double);
+void set_rom_fast_delay(double);
+void set_rom_tolerance(int);
 void set_humidity_sensor_delay(double);
 
 //VOICEBOX FUNCTION(S)
@@ -76,30 +157,81 @@ void turn_on_full_rgb(void);
 void turn_off_rgb(void);
 void alert_led(int);
 void reset_fade(void);
+void memory_led_out(uint8_t);
+void rgb_led_out(uint8_t);
 
 //HUMIDITY FUNCTION(S)
 int check_humidity_sensor(void);
 
+//SENSOR ARRAY FUNCTION(S)
+int add_channel(void);
+int add_dht_sensor(int);
+int add_dht_sensor(int, VersalinoBUS);
+int add_analog_sensor(int);
+int add_climate_channel(int, int);
+void set_channel(int, int);
+int channel_fresh(int);
+void acquire_sensors(void);
+void print_dht_health(void);
+
+//STATS FUNCTION(S)
+unsigned int check_anomalies(void);
+void print_stats(void);
+
+//CLIMATE FUNCTION(S)
+void update_climate(int);
+int climate_alarm(void);
+
 //BARGRAPH FUNCTION(S)
+void setup_bargraph(void);
 void fill_leds(int);
+int humidity_to_leds(int);
 void activate_bargraph();
 
 //RANGER FUNCTION(S)
 void setup_ranger(void);
 void find_range(void);
+void range_echo(unsigned int);
+int echo_to_cm(unsigned int);
+void range_edge(void);
+
+//EVENT FUNCTION(S)
+void drain_events(void);
 
 //C0 SENSOR FUNCTION(S)
 void get_C0_value();
 
 //MEMORY FUNCTION(S)
-void clearData(void);
+void set_log_storage(LogStorage*);
+void clearData(long);
 void reset_mem(void);
+void clear_step(void);
 void readData(void);
+void read_begin(void);
+long log_decode(long, struct log_line*);
+long read_record(long);
+void read_step(void);
 void mem_write(void);
 void mem_read(void);
+int rom_sample_due(void);
+void write_anchor(unsigned long);
+void log_write(byte, byte);
+byte log_crc(unsigned int, byte, byte);
+int log_valid(long);
+int log_blank(long);
+long log_find_head(void);
+void log_write_header(byte);
+void log_recover(void);
 
 //TIMING FUNCTION(S)
 void increment_timer(void);
+unsigned long now_seconds(void);
+void sync_time(unsigned long);
+
+//COMMAND FUNCTION(S)
+void poll_commands(void);
+void text_command(uint8_t);
+void run_command(command*);
 
 
 /*##############################
@@ -114,9 +246,6 @@ void increment_timer(void);
  * GND on SPK-
  * VCC on SPK+
  *********************************/
-//Create a SoftSerial Objet
-SoftwareSerial speakjet = SoftwareSerial(0, txPin);
-
 //The message array contains the command for sounds to be sent in order to inunciate the words "All your base belong to us." Check the SpeakJet Manual for more information
 //on producing words
 //All              Your         Base                 Are     Belong                       to          us
@@ -131,6 +260,9 @@ char range_sounds[] = {
 char humidity_sounds[] = {
   254,223,4,222,5,207,4,238, NULLTERM};
   
+char anomaly_sounds[] = {
+  200,19,200,19, NULLTERM};
+
 char c02_sounds[] = {
   240, NULLTERM};
 
@@ -138,118 +270,295 @@ char interrupt_sound[] = {
   NULLTERM
 };
 
-/***************************
- * TIMING VARIABLES
- ***************************/
-//init relative timer
-int timer = 0;
-int action_timer = 0; //keep parallel timer for sounds and other actions so they don't occur simultaneously
-//delay for whole program
-int global_delay = 100;
-int sound_delay = 1; //default delay for all sounds
-int delay_minutes_conv = (60000/global_delay);
-int delay_seconds_conv = (1000/global_delay);
-
-int max_uninterupted_delay = 10 * delay_seconds_conv; //sets max "uninteruptable" sound
-//delay for various sensors and components
-double rom_minutes = .0017; //how often to save sensor data
-double humid_speaker_seconds = 300; //how long to wait to alarm in seconds
-double ranger_speaker_seconds = 1; //how long to wait to alarm
-
-int rom_delay = rom_minutes * delay_minutes_conv; //minutes relative to global delay
-
-//delay for sounds
-int humid_speaker_delay = humid_speaker_seconds * delay_seconds_conv; //seconds relative to global delay
-int ranger_speaker_delay = ranger_speaker_seconds * delay_seconds_conv; //seconds relative to global delay
-
-int sound_playing= 0; //lock for sounds
+//Create a SoftSerial Objet
+R24U_LOCAL SoftwareSerial speakjet = SoftwareSerial(0, txPin);
 
 /***************************
- * LED VARIABLES
+ * BARGRAPH
+ * the bargraph object, its
+ * settings are in the device
  ***************************/
-int fade_reset = 40;
-int fadeAmount = fade_reset; //amount to fade by each iteration
-int brightness = 0; //start fade value at 0
-int memory_full_pin = 11;//memory full pin used to alert user 
-int rgb_redPin = A5;
-int rgb_bluePin = A4;
-int rgb_grnPin = A3;
-//when the EEPROM is full by fading in and out
+R24U_LOCAL SFEbarGraph BG;
 
 /***************************
- * HUMIDITY SETUP
- * DTA to Pin 6
+ * RGB PINS
  ***************************/
-dht22 DHT22;
-int DHTPIN = 6;     // what pin we're connected to
-int humidity_val= 0;
-int chk;
-//at what humidity level should the alarm go off
-int humidity_alarm_value = 40; 
+//rgb pins are fixed when compiling so they can be switched
+//together with a single port write (see FastPin.h)
+const int rgb_redPin = A5;
+const int rgb_bluePin = A4;
+const int rgb_grnPin = A3;
+typedef FastPins<rgb_redPin, rgb_bluePin, rgb_grnPin> rgb_pins;
 
 /***************************
- * BARGRAPH SETUP
- * LAT & SIN to MOSI 
- *   - LAT behind SIN such that
- *     SIN receives current first
- * CLK to SCK
- * VCC/+5V to 5V
- * GND to GND
+ * INTERRUPT VARIABLES
+ * shared with interrupts, which
+ * belong to the board rather than
+ * a device, so kept out of the
+ * device context
  ***************************/
-SFEbarGraph BG;
-int num_leds = 0;
+R24U_LOCAL EventRing<event, EVENT_RING_SIZE> events; //from interrupts to loop(), see drain_events()
+R24U_LOCAL volatile uint8_t *echo_in; //range finder echo pin's input register and bit
+R24U_LOCAL uint8_t echo_mask;
+R24U_LOCAL uint8_t echo_source; //echo pin number
+R24U_LOCAL unsigned long echo_start; //micros() when the echo went high
+R24U_LOCAL volatile uint8_t echo_high = 0; //the echo is high, echo_start holds when it went high
+R24U_LOCAL volatile uint8_t led_memory_pin = 11; //pin the memory led effect drives, see alert_led()
 
-/***************************
- * RANGE FINDER VARIABLES
- ***************************/
-//at what max range should the alarm go off (in cm)
-int range_alarm_value = 5;
-int trigPin = 9; //trig to pin 9
-int echoPin = 10; //echo to pin 10
+/*##############################
+ #      
+ #       DEVICE CONTEXT
+ #
+ #############################*/
+/*
+ * everything that changes while the
+ * device runs is kept in one struct
+ * instead of loose globals, so the
+ * functions below can be pointed at
+ * another device with set_device(),
+ * e.g. to simulate several of them.
+ * ctx is the device they work on.
+ *
+ * the hardware (SpeakJet, bargraph) and
+ * anything an interrupt reads are kept
+ * out of it (see COMPONENT SETUP), since
+ * there is only one of each on the board
+ * and interrupts can't follow ctx.
+ *
+ * built on a computer (see tools/host),
+ * ctx, device_state and the globals above
+ * are R24U_LOCAL, one set per thread, so
+ * several threads can each step devices of
+ * their own (see tools/fleet_sim.cpp).
+ */
+struct device
+{
+  /***************************
+   * TIMING VARIABLES
+   ***************************/
+  //init relative timer
+  int timer = 0;
+  int action_timer = 0; //keep parallel timer for sounds and other actions so they don't occur simultaneously
+  //delay for whole program
+  int global_delay = 100;
+  int sound_delay = 1; //default delay for all sounds
+  int delay_minutes_conv = (60000/global_delay);
+  int delay_seconds_conv = (1000/global_delay);
+
+  int max_uninterupted_delay = 10 * delay_seconds_conv; //sets max "uninteruptable" sound
+  //delay for various sensors and components
+  double rom_minutes = 1; //longest wait between saves while sensor data is stable
+  double rom_fast_seconds = 2; //shortest wait between saves while sensor data is changing
+  double humid_speaker_seconds = 300; //how long to wait to alarm in seconds
+  double ranger_speaker_seconds = 1; //how long to wait to alarm
+
+  int rom_delay = rom_minutes * delay_minutes_conv; //minutes relative to global delay
+  int rom_min_delay = rom_fast_seconds * delay_seconds_conv; //seconds relative to global delay
+  int rom_sample_delay = rom_min_delay; //current save interval, moves between rom_min_delay and rom_delay
+  int rom_ticks = 0; //ticks since the last save
+  int rom_due = SAMPLE_NONE; //why rom_sample_due() last said a save was due
+  //how far (in humidity %) a reading may drift from the last saved value before it is saved
+  int rom_tolerance = 2;
+  int rom_last_val[MAX_CHANNELS]; //last value saved for each channel
+
+  //clock kept in seconds, lined up with the host by sync_time()
+  unsigned long time_offset = 0; //added to uptime to get host time
+  int time_synced = 0; //set once the host has sent its time
+  unsigned long rom_last_time = 0; //time of the last saved record
+  int rom_anchor_count = ANCHOR_PERIOD; //samples since the last anchor
+
+  //delay for sounds
+  int humid_speaker_delay = humid_speaker_seconds * delay_seconds_conv; //seconds relative to global delay
+  int ranger_speaker_delay = ranger_speaker_seconds * delay_seconds_conv; //seconds relative to global delay
+
+  int sound_playing= 0; //lock for sounds
+
+  /***************************
+   * LED VARIABLES
+   ***************************/
+  unsigned int fade_ms = 1200; //time to fade in and out once
+  unsigned int blink_ms = 500; //time for one rgb alert blink
+  int memory_full_pin = 11;//memory full pin used to alert user 
+  //when the EEPROM is full by fading in and out
+
+  /***************************
+   * SENSOR ARRAY VARIABLES
+   * DHT22 and analog sensors on any
+   * pin or Versalino bus, read together
+   * by acquire_sensors(). each one fills
+   * a log channel.
+   ***************************/
+  dht22 dht_sensors[MAX_DHT_SENSORS];
+  int dht_count = 0;
+  int dht_channel[MAX_DHT_SENSORS]; //log channel holding each sensor's humidity
+  int dht_status[MAX_DHT_SENSORS]; //result of each sensor's last read, DHT22_OK or an error
+  dht22_health dht_health[MAX_DHT_SENSORS]; //read counts and backoff of each sensor
+  int analog_pins[MAX_ANALOG_SENSORS];
+  int analog_channel[MAX_ANALOG_SENSORS];
+  int analog_count = 0;
+  int channel_val[MAX_CHANNELS]; //latest reading of each channel, saved as one byte
+  stats channel_stats[MAX_CHANNELS]; //running statistics of each channel (see Stats.h)
+  unsigned long channel_time[MAX_CHANNELS]; //millis() of each channel's last reading
+  int channel_count = 0;
+  unsigned long acquire_last = 0; //when the last round of reads started (ms)
+
+  //dew point, heat index and absolute humidity of each
+  //DHT22, worked out after every good read (see Climate.h)
+  climate dht_climate[MAX_DHT_SENSORS];
+  //climate results saved as log channels, see add_climate_channel()
+  int climate_sensor[MAX_CLIMATE_CHANNELS];
+  int climate_kind[MAX_CLIMATE_CHANNELS];
+  int climate_channel[MAX_CLIMATE_CHANNELS];
+  int climate_count = 0;
+
+  /***************************
+   * HUMIDITY SETUP
+   * DTA to Pin 6
+   ***************************/
+  int DHTPIN = 6;     // what pin we're connected to
+  int humidity_val= 0;
+  int chk = -2; //result of DHT22's last read
+  //at what humidity level should the alarm go off
+  int humidity_alarm_value = 40; 
+  //alarm when the temperature is this close to the dew point (C),
+  //as things start to get damp. 0 turns it off
+  int dew_alarm_margin = 0;
+  //alarm when the heat index reaches this (C). 0 turns it off
+  int heat_alarm_value = 0;
+  //alarm when a channel reads this many standard deviations from
+  //its mean, or the same value this many reads in a row
+  //(reads are DHT22_PERIOD_MS apart). 0 turns either off,
+  //both are off until set_anomaly_alarm() is called
+  int anomaly_z = 0;
+  int anomaly_stuck = 0;
+  unsigned int anomaly_flags = 0; //flags check_anomalies() last saw, so each one sounds once
+
+  /***************************
+   * BARGRAPH SETUP
+   * LAT & SIN to MOSI 
+   *   - LAT behind SIN such that
+   *     SIN receives current first
+   * CLK to SCK
+   * VCC/+5V to 5V
+   * GND to GND
+   *
+   * see SPI NOR FLASH in LogStorage.h
+   * before sharing the SPI pins
+   ***************************/
+  int bargraph_latch = -1; //LAT pin, -1 while LAT is on MOSI
+  int num_leds = 0;
+
+  /***************************
+   * RANGE FINDER VARIABLES
+   ***************************/
+  //at what max range should the alarm go off (in cm)
+  int range_alarm_value = 5;
+  int trigPin = 9; //trig to pin 9
+  FastPinRef trig_pin; //trigPin's port and bit, looked up in setup_ranger()
+  int echoPin = 7; //echo to pin 7, it has an external interrupt
+  int range_interrupt = 0; //echo is timed by its pin's interrupt, else pulseIn()
+  int range_waiting = 0; //a ping is out and its echo hasn't come back
+  unsigned long range_ping = 0; //millis() of the last ping
+  int range_val = 0; //last distance (cm)
+
+  /***************************
+   * C0 SENSOR VARIABLES
+   ***************************/
+  int c0sensorval;
+  int c0sensorPin = A0;
+
+  /***************************
+   * MEM CONTROL VARIABLES
+   ***************************/
+  int control_val = WRITE;
+  long address_val = 0; //next free record slot
+  unsigned int log_base = 0; //sequence number of the record in slot 0
+
+  //where the log is kept, see LogStorage.h.
+  //to record to SPI flash instead, e.g.
+  //  SPIFlashStorage flash_store(A1, 1048576);
+  //  flash_store.begin(); set_log_storage(&flash_store);
+  //before log_recover() in setup()
+  EEPROMStorage eeprom_store;
+  LogStorage *log_store = &eeprom_store;
+  unsigned long log_header = 0; //address of the header, in the last block of the storage
+  long log_slots = 0; //number of records that fit in front of the header
+  long clear_next = 0; //next slot clear_step() sets back to LOG_BLANK, past clear_end once the header is rewritten
+  long clear_end = 0; //slots to clear, 0 when no clear is running
+  int read_running = 0; //the log is being sent to the host, see read_step()
+  long read_next = 0; //next slot read_step() sends
+
+  /***************************
+   * COMMAND VARIABLES
+   * requests from the host,
+   * see poll_commands()
+   ***************************/
+  command cmd_in; //binary request coming in (see Command.h)
+  int sync_digits = -1; //digits of the host time had since a "T", -1 if none is coming
+  unsigned long sync_value = 0; //host time so far
 
-/***************************
- * C0 SENSOR VARIABLES
- ***************************/
-int c0sensorval;
-int c0sensorPin = A0;
+};
 
-/***************************
- * MEM CONTROL VARIABLES
- ***************************/
-int control_val = 0;
-int address_val = 0;
+R24U_LOCAL device device_state;
+R24U_LOCAL device *ctx = &device_state; //device the functions work on
 
 /*#################################################
  # FUNCTIONS: CAN BE CALLED FROM THE MAIN PROGRAM
  # TO SET AND CONTROL VARIOUS ELEMENTS OF THE DEVICE
  # 
  #   CONTENTS:
+ #   DEVICE SETTER
  #   PIN SETTERS
  #   ALARM SETTERS
  #   TIMER SETTERS
  #   LED FUNCTION(S)
  #   HUMIDITY FUNCTION(S)
+ #   SENSOR ARRAY FUNCTION(S)
+ #   CLIMATE FUNCTION(S)
+ #   STATS FUNCTION(S)
  #   BARGRAPH FUNCTION(S)
  #   RANGER FUNCTION(S)
+ #   EVENT FUNCTION(S)
  #   MEMORY FUNCTION(S)
  #   TIMING FUNCTION(S)
+ #   COMMAND FUNCTION(S)
  #   VOICEBOX FUNCTION(S)
  ###################################################
  
+/***************************
+ * DEVICE SETTER
+ *
+ * CONTENTS:
+ *   void set_device(device*)
+ ***************************/
+/**
+ * make every function work on another
+ * device. the device's own setup has to be
+ * run for it, as for device_state in Setup()
+ */
+void set_device(device *new_device){
+  ctx = new_device;
+}
+
 /***************************
  * PIN SETTERS
  *
  * CONTENTS:
  *   void set_range_pins(int, int)
  *   void set_humidity_pins(int)
+ *   void set_bargraph_latch(int)
  ***************************/
 void set_range_pins(int new_trigPin, int new_echoPin){
-  trigPin = new_trigPin;
-  echoPin = new_echoPin;
+  ctx->trigPin = new_trigPin;
+  ctx->echoPin = new_echoPin;
 }
 
 void set_humidity_pins(int new_DHT22_pin){
-  DHTPIN = new_DHT22_pin;
+  ctx->DHTPIN = new_DHT22_pin;
+}
+
+void set_bargraph_latch(int new_latch_pin){
+  ctx->bargraph_latch = new_latch_pin;
 }
 
 /***************************
@@ -259,18 +568,34 @@ void set_humidity_pins(int new_DHT22_pin){
  *   void set_humidity_alarm(int)
  *   void set_range_alarm(int)
  *   void set_mem_full_led(int)
+ *   void set_dew_alarm(int)
+ *   void set_heat_alarm(int)
+ *   void set_anomaly_alarm(int, int)
  *   void check_timer_variables()
  ***************************/
 void set_humidity_alarm(int new_humidity_alarm){
-  humidity_alarm_value = new_humidity_alarm;
+  ctx->humidity_alarm_value = new_humidity_alarm;
 }
 
 void set_range_alarm(int new_range_alarm){
-  range_alarm_value = new_range_alarm;
+  ctx->range_alarm_value = new_range_alarm;
 }
 
 void set_mem_full_led(int new_mem_full_pin){
-  memory_full_pin = new_mem_full_pin;
+  ctx->memory_full_pin = new_mem_full_pin;
+}
+
+void set_dew_alarm(int new_dew_margin){
+  ctx->dew_alarm_margin = new_dew_margin;
+}
+
+void set_heat_alarm(int new_heat_alarm){
+  ctx->heat_alarm_value = new_heat_alarm;
+}
+
+void set_anomaly_alarm(int new_anomaly_z, int new_anomaly_stuck){
+  ctx->anomaly_z = new_anomaly_z;
+  ctx->anomaly_stuck = new_anomaly_stuck;
 }
 
 /*********************************
@@ -279,18 +604,29 @@ void set_mem_full_led(int new_mem_full_pin){
  * CONTENTS:
  *   void set_global_delay(double)
  *   void set_rom_sensor_delay(double)
+ *   void set_rom_fast_delay(double)
+ *   void set_rom_tolerance(int)
  *   void set_humidity_sensor_delay(double)
  *********************************/
 void set_global_delay(double gl_delay){
-  global_delay = gl_delay;
+  ctx->global_delay = gl_delay;
 }
 
 void set_rom_sensor_delay(double mew_rom_delay){
-  rom_delay = mew_rom_delay * (60000/global_delay); //minutes relative to global delay
+  ctx->rom_delay = mew_rom_delay * (60000/ctx->global_delay); //minutes relative to global delay
+}
+
+void set_rom_fast_delay(double new_rom_fast_delay){
+  ctx->rom_min_delay = new_rom_fast_delay * (1000/ctx->global_delay); //seconds relative to global delay
+  ctx->rom_sample_delay = ctx->rom_min_delay;
+}
+
+void set_rom_tolerance(int new_rom_tolerance){
+  ctx->rom_tolerance = new_rom_tolerance;
 }
 
 void set_humidity_sensor_delay(double new_humidity_delay){
-  humid_speaker_delay = new_humidity_delay * (1000/global_delay); //seconds relative to global delay
+  ctx->humid_speaker_delay = new_humidity_delay * (1000/ctx->global_delay); //seconds relative to global delay
 }
 
 /***************************
@@ -323,16 +659,13 @@ void setup_voicebox(){
   pinMode(RES, OUTPUT);
 
   //Configure all of the Event pins as outputs from Arduino, and set them Low.
-  for(int i=E0; i<=E7; i++)
-  {
-    pinMode(i, OUTPUT);
-    digitalWrite(i, LOW);
-  }
+  FastPins<E0, E1, E2, E3, E4, E5, E6, E7>::low();
+  FastPins<E0, E1, E2, E3, E4, E5, E6, E7>::output();
 
   //All I/O pins are configured. Reset the SpeakJet module
-  digitalWrite(RES, LOW);
+  FastPin<RES>::low();
   delay(100);
-  digitalWrite(RES, HIGH);
+  FastPin<RES>::high();
 
 }
 /**
@@ -342,13 +675,13 @@ void setup_voicebox(){
  */
 void play_sounds(char sounds[], int delay_value){
   //sounds are uninterruptable unless sound_interrupt() is called
-  if(!sound_playing){
+  if(!ctx->sound_playing){
     //Serial.println("Play Sound");
-    turn_on_full_rgb();
+    led_fx(LED_RGB, FX_BLINK, ctx->blink_ms);
     speakjet.print(sounds);
-    sound_playing = 1;
-    sound_delay = delay_value;
-    action_timer=0; //restart action timer
+    ctx->sound_playing = 1;
+    ctx->sound_delay = delay_value;
+    ctx->action_timer=0; //restart action timer
   }
 }
 /**
@@ -359,17 +692,17 @@ void play_sounds(char sounds[], int delay_value){
  * if statement here
  */
 void check_sound_lock(){
-  if(action_timer%sound_delay ==0 && sound_playing == 1){
-    sound_playing = 0;
-    turn_off_rgb();
+  if(ctx->action_timer%ctx->sound_delay ==0 && ctx->sound_playing == 1){
+    ctx->sound_playing = 0;
+    led_fx(LED_RGB, FX_OFF, 0);
   }
 }
 /**
  * interrupt for sounds
  */
 void sound_interrupt(){
-  if(sound_delay>max_uninterupted_delay){
-    sound_playing = 0;
+  if(ctx->sound_delay>ctx->max_uninterupted_delay){
+    ctx->sound_playing = 0;
     play_sounds(interrupt_sound, 1);
   }
 }
@@ -383,56 +716,70 @@ void sound_interrupt(){
  *  void turn_on_full_rgb()
  *  turn_off_rgb()
  *  void alert_led(int)
+ *  void memory_led_out(uint8_t)
+ *  void rgb_led_out(uint8_t)
  ***************************/
 /**
  * Sets initial values of 
- * LEDS
+ * LEDS and starts the background
+ * effects (see LedFx.h)
  */
 void setup_leds(){
-  pinMode(memory_full_pin, OUTPUT);
-  pinMode(rgb_redPin, OUTPUT);
-  pinMode(rgb_bluePin, OUTPUT);
-  pinMode(rgb_grnPin, OUTPUT);
+  pinMode(ctx->memory_full_pin, OUTPUT);
+  led_memory_pin = ctx->memory_full_pin;
+  rgb_pins::output();
+  led_fx_attach(LED_MEMORY, memory_led_out);
+  led_fx_attach(LED_RGB, rgb_led_out);
+  led_fx_begin();
 }
 /**
- * resets fade values
+ * stops the memory full fade
+ * and turns the led off
  */
 void reset_fade(){
-  //reset fades
-  fadeAmount = fade_reset; 
-  brightness = 0;
+  led_fx(LED_MEMORY, FX_OFF, 0);
 }
 /**
  * turns on all values of rgb
  */
 void turn_on_full_rgb(){
-  digitalWrite(rgb_redPin, HIGH);    
-  digitalWrite(rgb_bluePin, HIGH);   
-  digitalWrite(rgb_grnPin, HIGH);   
+  rgb_pins::high();
 }
 /**
  * turns off all pi of rgb
  */
 void turn_off_rgb(){
-  digitalWrite(rgb_redPin, LOW);    
-  digitalWrite(rgb_bluePin, LOW);   
-  digitalWrite(rgb_grnPin, LOW);   
+  rgb_pins::low();
 }
 /** 
- * fades a pin in and out based on the 
- * global delay time. 
+ * fades a pin in and out every fade_ms.
+ * the fade runs in the background, so
+ * calling this again while it is running
+ * changes nothing.
  */
 void alert_led(int fadepin){
-  // set the brightness of pin 9:
-  analogWrite(fadepin, brightness);    
-
-  // change the brightness for next time through the loop:
-  brightness = brightness + fadeAmount;
-
-  // reverse the direction of the fading at the ends of the fade: 
-  if (brightness == 0 || brightness == 240) {
-    fadeAmount = -fadeAmount ; 
-  }     
+  ctx->memory_full_pin = fadepin;
+  led_memory_pin = fadepin;
+  led_fx(LED_MEMORY, FX_FADE, ctx->fade_ms);
+}
+/**
+ * effect output for the memory full led,
+ * called from the effect interrupt
+ */
+void memory_led_out(uint8_t level){
+  analogWrite(led_memory_pin, level);
+}
+/**
+ * effect output for the rgb led. it has no
+ * PWM pins, so any brightness turns it on.
+ * called from the effect interrupt
+ */
+void rgb_led_out(uint8_t level){
+  if(level){
+    turn_on_full_rgb();
+  }else{
+    turn_off_rgb();
+  }
 }
 
 
@@ -443,13 +790,13 @@ void alert_led(int fadepin){
  *   int check_humidity_sensor()
  ***************************/
 /**
- * checks if humidity sensor is ready
+ * checks if the last read of the humidity
+ * sensor (see acquire_sensors()) worked
  * reuturns a boolean true or false
  */
 int check_humidity_sensor(){
-  chk = DHT22.read();
   //Serial.println(chk);
-  switch (chk)
+  switch (ctx->chk)
   {
   case 0: 
     return 1;
@@ -460,29 +807,350 @@ int check_humidity_sensor(){
   }
 }
 
+/***************************
+ * SENSOR ARRAY FUNCTION(S)
+ *
+ * CONTENTS:
+ *   int add_channel()
+ *   int add_dht_sensor(int)
+ *   int add_dht_sensor(int, VersalinoBUS)
+ *   int add_analog_sensor(int)
+ *   int add_climate_channel(int, int)
+ *   void set_channel(int, int)
+ *   int channel_fresh(int)
+ *   void acquire_sensors()
+ *   void print_dht_health()
+ ***************************/
+/**
+ * reserve the next log channel.
+ * returns -1 if they are all used
+ */
+int add_channel(){
+  if(ctx->channel_count >= MAX_CHANNELS){
+    return -1;
+  }
+  ctx->channel_val[ctx->channel_count] = 0;
+  stats_reset(&ctx->channel_stats[ctx->channel_count]);
+  return ctx->channel_count++;
+}
+/**
+ * add a DHT22 on a pin, or on a pin of
+ * a Versalino bus (e.g. add_dht_sensor(D1, BUSB)).
+ * returns the log channel of its humidity,
+ * -1 if there is no room.
+ *
+ * used in Setup();
+ */
+int add_dht_sensor(int pin){
+  if(ctx->dht_count >= MAX_DHT_SENSORS){
+    return -1;
+  }
+  ctx->dht_sensors[ctx->dht_count].attach(pin);
+  ctx->dht_status[ctx->dht_count] = DHT22_ERROR_TIMEOUT;
+  ctx->dht_channel[ctx->dht_count] = add_channel();
+  return ctx->dht_channel[ctx->dht_count++];
+}
+
+int add_dht_sensor(int pin, VersalinoBUS bus){
+  if(ctx->dht_count >= MAX_DHT_SENSORS){
+    return -1;
+  }
+  ctx->dht_sensors[ctx->dht_count].attach(pin, bus);
+  ctx->dht_status[ctx->dht_count] = DHT22_ERROR_TIMEOUT;
+  ctx->dht_channel[ctx->dht_count] = add_channel();
+  return ctx->dht_channel[ctx->dht_count++];
+}
+/**
+ * add an analog sensor, its reading is
+ * saved as the top 8 of its 10 bits.
+ * returns its log channel, -1 if there
+ * is no room.
+ *
+ * used in Setup();
+ */
+int add_analog_sensor(int pin){
+  if(ctx->analog_count >= MAX_ANALOG_SENSORS){
+    return -1;
+  }
+  ctx->analog_pins[ctx->analog_count] = pin;
+  ctx->analog_channel[ctx->analog_count] = add_channel();
+  return ctx->analog_channel[ctx->analog_count++];
+}
+/**
+ * save one of a DHT22's climate results
+ * (CLIMATE_DEW, CLIMATE_HEAT or CLIMATE_ABS)
+ * in its own log channel. sensor is the order
+ * the DHT22 was added in, starting at 0.
+ * temperatures are saved as C + 40 and
+ * absolute humidity in g/m3.
+ * returns the log channel, -1 if there is no room.
+ *
+ * used in Setup();
+ */
+int add_climate_channel(int sensor, int kind){
+  if(ctx->climate_count >= MAX_CLIMATE_CHANNELS || sensor < 0 || sensor >= ctx->dht_count){
+    return -1;
+  }
+  ctx->climate_sensor[ctx->climate_count] = sensor;
+  ctx->climate_kind[ctx->climate_count] = kind;
+  ctx->climate_channel[ctx->climate_count] = add_channel();
+  return ctx->climate_channel[ctx->climate_count++];
+}
+/**
+ * store a new reading of a channel and
+ * add it to the channel's statistics
+ */
+void set_channel(int channel, int value){
+  ctx->channel_val[channel] = value;
+  ctx->channel_time[channel] = millis();
+  stats_add(&ctx->channel_stats[channel], value, ctx->anomaly_z, ctx->anomaly_stuck);
+}
+/**
+ * true if a channel has had a reading in
+ * the last CHANNEL_STALE_MS. a DHT22 that
+ * fails keeps its last good value, which
+ * goes stale instead of being saved again.
+ */
+int channel_fresh(int channel){
+  return ctx->channel_stats[channel].n && millis() - ctx->channel_time[channel] < CHANNEL_STALE_MS;
+}
+/**
+ * read every sensor, at most once every
+ * DHT22_PERIOD_MS.
+ *
+ * the start pulses are staggered: the analog
+ * sensors are read while the first DHT22's
+ * runs, and each later DHT22 is woken just
+ * before the one ahead of it is read. a read
+ * takes longer than DHT22_START_US, so the
+ * next sensor is ready as soon as it ends,
+ * only one start wait is paid per round and no
+ * sensor is held low for more than one read.
+ *
+ * a DHT22 that keeps failing is skipped for
+ * longer and longer (see dht22_health), so a
+ * broken or missing sensor costs next to
+ * nothing. only good reads reach its channel.
+ */
+void acquire_sensors(){
+  if(millis() - ctx->acquire_last < DHT22_PERIOD_MS){
+    return;
+  }
+  ctx->acquire_last = millis();
+  int due[MAX_DHT_SENSORS];
+  int due_count = 0;
+  for(int i = 0; i<ctx->dht_count; i++){
+    if(ctx->dht_health[i].due(ctx->acquire_last)){
+      due[due_count++] = i;
+    }
+  }
+  unsigned long woken = micros();
+  if(due_count){
+    ctx->dht_sensors[due[0]].start();
+  }
+  for(int i = 0; i<ctx->analog_count; i++){
+    set_channel(ctx->analog_channel[i], analogRead(ctx->analog_pins[i]) >> 2);
+  }
+  for(int k = 0; k<due_count; k++){
+    int i = due[k];
+    //wait out this sensor's start pulse. after the read
+    //ahead of it it has already run, unless that read
+    //failed early
+    while(micros() - woken < DHT22_START_US);
+    if(k + 1 < due_count){
+      ctx->dht_sensors[due[k + 1]].start();
+      woken = micros();
+    }
+    ctx->dht_status[i] = ctx->dht_sensors[i].finish();
+    ctx->dht_health[i].record(ctx->dht_status[i], ctx->acquire_last);
+    if(ctx->dht_status[i] == DHT22_OK){
+      set_channel(ctx->dht_channel[i], ctx->dht_sensors[i].humidity);
+      update_climate(i);
+    }
+  }
+  ctx->chk = ctx->dht_status[0];
+}
+/**
+ * print each DHT22's read history, one per line:
+ *   Hsensor,good,timeouts,checksums,stuck,failures,age
+ * failures is the number of failed reads in a row
+ * and age the seconds since the last good one.
+ */
+void print_dht_health(){
+  for(int i = 0; i<ctx->dht_count; i++){
+    dht22_health *h = &ctx->dht_health[i];
+    Serial.print('H');
+    Serial.print(i);
+    Serial.print(',');
+    Serial.print(h->good);
+    Serial.print(',');
+    Serial.print(h->timeouts);
+    Serial.print(',');
+    Serial.print(h->checksums);
+    Serial.print(',');
+    Serial.print(h->stuck);
+    Serial.print(',');
+    Serial.print(h->failures);
+    Serial.print(',');
+    Serial.println(h->age(millis()) / 1000);
+  }
+}
+
+/***************************
+ * CLIMATE FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void update_climate(int)
+ *   int climate_alarm()
+ ***************************/
+/**
+ * work out a DHT22's dew point, heat index
+ * and absolute humidity from its new reading
+ * and copy them into their log channels
+ */
+void update_climate(int sensor){
+  dht22 &dht = ctx->dht_sensors[sensor];
+  climate *result = &ctx->dht_climate[sensor];
+  //the DHT22 reads in tenths, so this is exact
+  int temp10 = (int)(dht.temperature * 10 + (dht.temperature < 0 ? -0.5 : 0.5));
+  int rh10 = (int)(dht.humidity * 10 + 0.5);
+  climate_update(result, temp10, rh10);
+  for(int c = 0; c<ctx->climate_count; c++){
+    if(ctx->climate_sensor[c] != sensor){
+      continue;
+    }
+    int value;
+    switch(ctx->climate_kind[c]){
+    case CLIMATE_DEW:
+      value = result->dew10/10 + 40;
+      break;
+    case CLIMATE_HEAT:
+      value = result->heat10/10 + 40;
+      break;
+    default:
+      value = result->abs10/10;
+      break;
+    }
+    set_channel(ctx->climate_channel[c], constrain(value, 0, 255));
+  }
+}
+/**
+ * true when the first DHT22's air is close
+ * to its dew point or its heat index is too
+ * high (see set_dew_alarm(), set_heat_alarm())
+ */
+int climate_alarm(){
+  if(!check_humidity_sensor() || !channel_fresh(ctx->dht_channel[0])){
+    return 0;
+  }
+  dht22 &dht = ctx->dht_sensors[0];
+  int temp10 = (int)(dht.temperature * 10 + (dht.temperature < 0 ? -0.5 : 0.5));
+  if(ctx->dew_alarm_margin && temp10 - ctx->dht_climate[0].dew10 <= ctx->dew_alarm_margin*10){
+    return 1;
+  }
+  if(ctx->heat_alarm_value && ctx->dht_climate[0].heat10 >= ctx->heat_alarm_value*10){
+    return 1;
+  }
+  return 0;
+}
+
+/***************************
+ * STATS FUNCTION(S)
+ *
+ * CONTENTS:
+ *   unsigned int check_anomalies()
+ *   void print_stats()
+ ***************************/
+/**
+ * sound the anomaly alarm when a channel's
+ * reading turns into a spike or gets stuck
+ * (see set_anomaly_alarm()). returns the
+ * flags of every channel, two bits each
+ * starting with channel 0.
+ */
+unsigned int check_anomalies(){
+  unsigned int flags = 0;
+  for(int c = 0; c<ctx->channel_count; c++){
+    flags |= (unsigned int)ctx->channel_stats[c].flags << (2*c);
+  }
+  if(flags & ~ctx->anomaly_flags){
+    play_sounds(anomaly_sounds, ctx->ranger_speaker_delay);
+  }
+  ctx->anomaly_flags = flags;
+  return flags;
+}
+/**
+ * print each channel's statistics, one per line:
+ *   Schannel,count,mean,deviation,average,flags,bucket0,...,bucket7
+ * average is the moving average, flags are
+ * STATS_SPIKE and STATS_STUCK, and the buckets
+ * count readings in steps of 32 from 0.
+ */
+void print_stats(){
+  for(int c = 0; c<ctx->channel_count; c++){
+    stats *s = &ctx->channel_stats[c];
+    Serial.print('S');
+    Serial.print(c);
+    Serial.print(',');
+    Serial.print(s->n);
+    Serial.print(',');
+    Serial.print(s->mean);
+    Serial.print(',');
+    Serial.print(sqrt(stats_variance(s)));
+    Serial.print(',');
+    Serial.print(stats_average(s));
+    Serial.print(',');
+    Serial.print(s->flags);
+    for(int b = 0; b<STATS_BUCKETS; b++){
+      Serial.print(',');
+      Serial.print(s->bucket[b]);
+    }
+    Serial.println();
+  }
+}
+
 /***************************
  * BARGRAPH FUNCTION(S)
  * 
  * CONTENTS:
+ *   void setup_bargraph()
  *   void fill_leds(int)
+ *   int humidity_to_leds(int)
  *   void activate_bargraph()
  ***************************/
+/**
+ * start the bargraph, latched by its own pin
+ * if it has one (see set_bargraph_latch())
+ * used in Setup()
+ */
+void setup_bargraph(){
+  if(ctx->bargraph_latch >= 0){
+    BG.begin(1, ctx->bargraph_latch);
+  }else{
+    BG.begin();
+  }
+}
 /**
  * find the inverse of the max led
  * so the green leds are the first to light up
- * then loop through and light each LED from the 
- * end to the inverse value. 
+ * then light each LED from the end to the
+ * inverse value. the LEDs are built up as bits
+ * and sent in one go instead of painting them
+ * one at a time.
  *
  * Example: if max_led is 7 then you will light up
  *          led #'s 29 - 22;
  */
 void fill_leds(int max_led){
-  int inverse = 29-max_led;
-  BG.clear();
-  for(int i = 29; i>=inverse; i--){
-    BG.paint(i, HIGH);
-  } 
-  BG.send();
+  int inverse = constrain(29-max_led, 0, 29);
+  BG.sendLong((0x3FFFFFFFUL >> inverse) << inverse);
+}
+/**
+ * number of bargraph leds (0 - 30)
+ * to light for a humidity
+ */
+int humidity_to_leds(int humidity){
+  return (int)(humidity/3.33);
 }
 /**
  * get humidity value and convert it to
@@ -493,15 +1161,17 @@ void fill_leds(int max_led){
  */
 void activate_bargraph(){
   if(check_humidity_sensor()){
-    humidity_val = DHT22.humidity;  //get humidity
-    num_leds = (int)(humidity_val/3.33); //convert to 0-30
-    fill_leds(num_leds); //light up leds
+    ctx->humidity_val = ctx->dht_sensors[0].humidity;  //get humidity
+    ctx->num_leds = humidity_to_leds(ctx->humidity_val); //convert to 0-30
+    fill_leds(ctx->num_leds); //light up leds
   }
 
-  //alarm if humidity is below alarm value and proper increment is reached
-  if(humidity_val>=humidity_alarm_value){
-    play_sounds(humidity_sounds, humid_speaker_delay);
-  }else if(humidity_val<humidity_alarm_value){
+  //alarm if humidity is below alarm value and proper increment is reached.
+  //a reading gone stale because the sensor is failing is not used
+  int humidity_fresh = ctx->dht_count && channel_fresh(ctx->dht_channel[0]);
+  if((humidity_fresh && ctx->humidity_val>=ctx->humidity_alarm_value) || climate_alarm()){
+    play_sounds(humidity_sounds, ctx->humid_speaker_delay);
+  }else{
     sound_interrupt();
   }
 }
@@ -512,34 +1182,127 @@ void activate_bargraph(){
  * CONTENTS:
  *   void setup_ranger()
  *   void find_range()
+ *   void range_echo(unsigned int)
+ *   int echo_to_cm(unsigned int)
+ *   void range_edge()
  ***************************/
 /**
- * sets all necessary pins for range sensor
+ * sets all necessary pins for range sensor.
+ * an echo pin with an external interrupt
+ * (pins 0, 1, 2, 3 and 7 on the Leonardo,
+ * 0 and 2 are the SpeakJet's) is timed by
+ * the interrupt, any other pin with pulseIn().
+ * pin change interrupts can't be used, the
+ * SpeakJet's SoftwareSerial owns them.
  * used in Setup()
  */
 void setup_ranger(){
-  pinMode(trigPin, OUTPUT);
-  pinMode(echoPin, INPUT_PULLUP);
+  pinMode(ctx->trigPin, OUTPUT);
+  pinMode(ctx->echoPin, INPUT_PULLUP);
+  ctx->trig_pin.attach(ctx->trigPin);
+
+  int irq = digitalPinToInterrupt(ctx->echoPin);
+  ctx->range_interrupt = irq != NOT_AN_INTERRUPT;
+  if(ctx->range_interrupt){
+    echo_in = portInputRegister(digitalPinToPort(ctx->echoPin));
+    echo_mask = digitalPinToBitMask(ctx->echoPin);
+    echo_source = ctx->echoPin;
+    echo_high = 0;
+    attachInterrupt(irq, range_edge, CHANGE);
+  }
 }
 /**
- * Scan the range finder values and
- * alert if the values are below a certain level
+ * ping the range finder. the echo is timed
+ * by its pin's interrupt and handled by
+ * range_echo() once drain_events() picks it
+ * up, so this doesn't wait for it.
  */
 void find_range(){
-  int duration, distance;
-  //pulse range finder
-  digitalWrite(trigPin, HIGH);
-  delayMicroseconds(2000);
-  digitalWrite(trigPin, LOW);
-  duration = pulseIn(echoPin, HIGH);
-
-  //convert pulse value to cm
-  distance = (duration/2) / 29.1;
+  if(!ctx->range_interrupt){
+    //no interrupt on this pin, so wait for the echo here
+    ctx->trig_pin.high();
+    delayMicroseconds(RANGE_TRIGGER_US);
+    ctx->trig_pin.low();
+    unsigned long duration = pulseIn(ctx->echoPin, HIGH);
+    if(duration){
+      event echo = {EVENT_ECHO, (uint8_t)ctx->echoPin, (uint16_t)min(duration, 0xFFFFUL)};
+      events.push(echo);
+    }
+    return;
+  }
+  unsigned long now = millis();
+  if(now - ctx->range_ping < (ctx->range_waiting ? RANGE_TIMEOUT_MS : RANGE_PERIOD_MS)){
+    return;
+  }
+  ctx->trig_pin.high();
+  delayMicroseconds(RANGE_TRIGGER_US);
+  ctx->trig_pin.low();
+  ctx->range_ping = now;
+  ctx->range_waiting = 1;
+}
+/**
+ * an echo came back, alert if the
+ * distance is below a certain level
+ */
+void range_echo(unsigned int duration){
+  ctx->range_waiting = 0;
+  ctx->range_val = echo_to_cm(duration);
 
-  //Serial.println(distance);
+  //Serial.println(ctx->range_val);
   //set off alarm if distance is lte alarm value
-  if(distance<=range_alarm_value){
-    play_sounds(range_sounds, ranger_speaker_delay);
+  if(ctx->range_val<=ctx->range_alarm_value){
+    play_sounds(range_sounds, ctx->ranger_speaker_delay);
+  }
+}
+/**
+ * convert an echo pulse (microseconds)
+ * to a distance in cm. sound takes
+ * 29.1 us to go a cm and the pulse
+ * covers the way there and back.
+ */
+int echo_to_cm(unsigned int duration){
+  return (duration/2) / 29.1;
+}
+/**
+ * times the echo pulse: starts on the rising
+ * edge and hands the length to loop() on the
+ * falling one. called from the echo pin's
+ * interrupt on every change.
+ */
+void range_edge(){
+  if(*echo_in & echo_mask){
+    echo_start = micros();
+    echo_high = 1;
+  }else if(echo_high){
+    event echo = {EVENT_ECHO, echo_source, (uint16_t)min(micros() - echo_start, 0xFFFFUL)};
+    events.push(echo);
+    echo_high = 0;
+  }
+}
+
+/***************************
+ * EVENT FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void drain_events()
+ ***************************/
+/**
+ * handle what the interrupts have handed
+ * over, at most EVENT_BATCH per loop so a
+ * burst doesn't hold up everything else.
+ * anything left waits for the next loop.
+ */
+void drain_events(){
+  event batch[EVENT_BATCH];
+  uint8_t count = events.pop(batch, EVENT_BATCH);
+  for(uint8_t i = 0; i<count; i++){
+    switch(batch[i].type){
+    case EVENT_ECHO:
+      range_echo(batch[i].value);
+      break;
+    default:
+      break;
+    }
   }
 }
 
@@ -550,7 +1313,7 @@ void find_range(){
  *   void get_C0_value()
  ***************************/
 void get_C0_value(){
-  c0sensorval = analogRead(c0sensorPin);       // read analog input pin 0
+  ctx->c0sensorval = analogRead(ctx->c0sensorPin);       // read analog input pin 0
   //do something with the c0 sensor...
   //Serial.println(sensorValue, DEC);  // prints the value read
 }
@@ -559,55 +1322,239 @@ void get_C0_value(){
  * MEMORY FUNCTION(S)
  * 
  * CONTENTS:
- *   void clearData()
+ *   void set_log_storage(LogStorage*)
+ *   void clearData(long)
  *   void reset_mem()
+ *   void clear_step()
  *   void readData()
+ *   void read_begin()
+ *   long log_decode(long, log_line*)
+ *   long read_record(long)
+ *   void read_step()
  *   void mem_write()
  *   void mem_read()
+ *   int rom_sample_due()
+ *   void write_anchor(unsigned long)
+ *   void log_write(byte, byte)
+ *   byte log_crc(unsigned int, byte, byte)
+ *   int log_valid(long)
+ *   long log_find_head()
+ *   void log_write_header(byte)
+ *   void log_recover()
  ***************************/
 
 /**
- * Set all data in EEPROM address
- * values to 0.00
+ * choose the storage the log is written
+ * through. must be called before log_recover()
  */
-void clearData(){
-  for(int i = 0; i<ADDRESSBIT; i++){
-    EEPROM.write(i, 0);
+void set_log_storage(LogStorage *new_log_store){
+  ctx->log_store = new_log_store;
+}
+/**
+ * Set the given number of record slots back
+ * to LOG_BLANK. every slot past the last
+ * record is already blank, so only the
+ * used ones need clearing.
+ * cleared a block at a time (CLEAR_CHUNK
+ * slots on the EEPROM), feeding the watchdog
+ * after each, since clearing the whole
+ * storage takes a few seconds.
+ */
+void clearData(long slots){
+  //flash erases whole blocks, so a smaller step would erase each one again
+  long chunk = max((long)CLEAR_CHUNK, (long)(ctx->log_store->blockSize() / REC_SIZE));
+  for(long slot = 0; slot<slots; slot += chunk){
+    ctx->log_store->erase(slot * REC_SIZE, min(slot + chunk, slots) * REC_SIZE);
+    watch_feed();
   }
 }
 /**
  * Fully reset the EEPROM memory and 
  * memory pointer values
+ *
+ * the old records are cleared by clear_step(),
+ * a little on each loop, so this doesn't wait
+ * for the storage.
  */
 void reset_mem(){
-  //set all values to 0
-  clearData(); 
-  //set the address bit (saved address) back to zero
-  EEPROM.write(ADDRESSBIT, 0);
+  //carry the sequence on so it keeps increasing
+  ctx->log_base = ctx->log_base + ctx->address_val;
+  //mark the clear as started so a power loss part way
+  //through is finished at the next boot
+  log_write_header(LOG_CLEARING);
+  //a clear still running from before starts over
+  ctx->clear_end = max(ctx->clear_end, ctx->address_val);
+  ctx->clear_next = 0;
   //set controller to write
-  EEPROM.write(CONTROLBIT, WRITE);
+  ctx->control_val = WRITE;
   //reset address value to zero
-  address_val = 0;
+  ctx->address_val = 0;
+  //start the new recording with an anchor
+  ctx->rom_anchor_count = ANCHOR_PERIOD;
   //output value to indicate the memory has been reset
   Serial.println("-1");
-  //wait for the serial connection to be closed
-  while(Serial);
 }
 /**
- * loop through all available EEPROM 
- * and output the value at each address 
- * location.
+ * clear the next few slots of a clear started
+ * by reset_mem(), called every loop after
+ * mem_write(). does nothing while the storage
+ * is still busy with what was written or erased
+ * before (a flash sector erase runs on after
+ * erase() returns), so it never holds up the
+ * loop, and marks the header once everything
+ * is clear.
+ */
+void clear_step(){
+  if(!ctx->clear_end || ctx->log_store->busy()){
+    return;
+  }
+  //rewriting the header erases its block too, so it is
+  //sent on a later loop once that erase has finished
+  if(ctx->clear_next == ctx->clear_end){
+    log_write_header(0);
+    ctx->clear_next++;
+    return;
+  }
+  if(ctx->clear_next > ctx->clear_end){
+    ctx->log_store->sync();
+    ctx->clear_end = 0;
+    return;
+  }
+  //a whole block at a time, flash can't erase less
+  long chunk = max((long)CLEAR_CHUNK, (long)(ctx->log_store->blockSize() / REC_SIZE));
+  long to = min(ctx->clear_next + chunk, ctx->clear_end);
+  ctx->log_store->erase(ctx->clear_next * REC_SIZE, to * REC_SIZE);
+  ctx->clear_next = to;
+}
+/**
+ * loop through all recorded EEPROM records
+ * and output them one per line:
+ *   #count   number of records that follow
+ *   @time    anchor with host time in seconds
+ *   ~time    anchor with device uptime in seconds
+ *   delta,value  channel 0 sample taken delta seconds
+ *                after the previous record
+ *   +channel,value  sample of another channel taken
+ *                with the record before
+ *
+ * sends the whole log before returning, the
+ * loop sends it a little at a time instead
+ * (see mem_read())
  */
 void readData(){
-  //loop until the highest recorded bit and 
+  read_begin();
+  //loop until the highest recorded slot and
   //output the data
-  for(int i = 0; i<ADDRESSBIT; i++){
-    float val = EEPROM.read(i);
-    Serial.println(val, DEC);
+  for(long i = 0; i<ctx->address_val; ){
+    i = read_record(i);
     delay(10);
+    watch_feed();
   }
   delay(100);
 }
+/**
+ * send the line saying how many
+ * records are about to follow
+ */
+void read_begin(){
+  ctx->log_store->sync();
+  Serial.print('#');
+  Serial.println(ctx->address_val);
+}
+/**
+ * one line of the log as read_record()
+ * sends it, see readData()
+ */
+struct log_line
+{
+  char mark; //'@' or '~' anchor, '+' another channel, ',' channel 0, 0 if there is nothing to send
+  byte number; //delta or channel, before the comma
+  unsigned long value; //anchor time or sample value
+};
+/**
+ * decode the record at a slot, or the whole
+ * anchor starting there, into a line and
+ * return the slot after it. kept apart from
+ * read_record() so it can be timed without
+ * Serial (see Benchmark.h)
+ */
+long log_decode(long i, struct log_line *line){
+  line->mark = 0;
+  //a record cut short by a power loss is left out
+  if(!log_valid(i)){
+    return i + 1;
+  }
+  byte header = ctx->log_store->read(i*REC_SIZE);
+  if((header & (REC_ANCHOR | REC_CHANNEL)) == REC_ANCHOR){
+    //gather the anchor bytes, most significant first.
+    //an anchor cut short by a power loss is skipped,
+    //each part is checked like a record of its own
+    long first = i;
+    unsigned long anchor_time = 0;
+    int parts = 0;
+    header &= ~REC_PART;
+    while(parts<ANCHOR_BYTES && i<ctx->address_val && log_valid(i) && ctx->log_store->read(i*REC_SIZE) == (header | parts)){
+      anchor_time = (anchor_time << 8) | ctx->log_store->read(i*REC_SIZE + 1);
+      parts++;
+      i++;
+    }
+    if(parts == ANCHOR_BYTES){
+      line->mark = (header & REC_SYNCED) ? '@' : '~';
+      line->value = anchor_time;
+    }
+    //the rest of an anchor whose first part was lost
+    return max(i, first + 1);
+  }else if(header & REC_ANCHOR){
+    line->mark = '+';
+    line->number = header & REC_CHANNEL_MASK;
+  }else{
+    line->mark = ',';
+    line->number = header;
+  }
+  line->value = ctx->log_store->read(i*REC_SIZE + 1);
+  return i + 1;
+}
+/**
+ * output the record at a slot, or the whole
+ * anchor starting there, and return the
+ * slot after it
+ */
+long read_record(long i){
+  struct log_line line;
+  i = log_decode(i, &line);
+  if(line.mark == '@' || line.mark == '~'){
+    Serial.print(line.mark);
+    Serial.println(line.value);
+  }else if(line.mark){
+    if(line.mark == '+'){
+      Serial.print('+');
+    }
+    Serial.print(line.number, DEC);
+    Serial.print(',');
+    Serial.println(line.value, DEC);
+  }
+  return i;
+}
+/**
+ * send the next READ_CHUNK records of a log
+ * started by mem_read(), called every loop.
+ * once everything has gone the log is reset
+ * (see reset_mem()).
+ */
+void read_step(){
+  if(!ctx->read_running){
+    return;
+  }
+  for(int n = 0; n<READ_CHUNK && ctx->read_next<ctx->address_val; n++){
+    ctx->read_next = read_record(ctx->read_next);
+    //give the host time to keep up
+    delay(10);
+  }
+  if(ctx->read_next >= ctx->address_val){
+    ctx->read_running = 0;
+    reset_mem();
+  }
+}
 /**
  * write a value to the current (saved) memory
  * address.
@@ -616,27 +1563,230 @@ void readData(){
  * change the control value to read.
  */
 void mem_write(){
-  //record data from sensors starting at address 0
-  EEPROM.write(address_val, humidity_val);
-  address_val=  address_val + 1;
-  if(address_val == ADDRESSBIT){
-    EEPROM.write(CONTROLBIT, READ);
+  unsigned long now = now_seconds();
+  //an anchor is needed if the gap won't fit in a sample header
+  //or enough samples have gone by since the last one
+  int anchor = ctx->rom_anchor_count >= ANCHOR_PERIOD || now - ctx->rom_last_time > REC_MAX_DELTA;
+  int needed = (anchor ? ANCHOR_BYTES : 0) + max(ctx->channel_count, 1);
+  //the log is being sent and will be cleared after
+  if(ctx->read_running){
+    return;
+  }
+  if(ctx->address_val + needed > ctx->log_slots){
+    ctx->control_val = READ;
+    return;
+  }
+  //new records wait for the clear to get past them, and
+  //for an erase it left running (see clear_step())
+  if(ctx->clear_end && (ctx->address_val + needed > ctx->clear_next || ctx->log_store->busy())){
+    return;
   }
+  //channel 0 carries the time, so nothing is saved while
+  //its sensor is failing, rather than saving an old value
+  if(!channel_fresh(0)){
+    return;
+  }
+  if(anchor){
+    write_anchor(now);
+  }
+  //record data from sensors starting at slot 0.
+  //channel 0 carries the time, the rest follow it
+  log_write(now - ctx->rom_last_time, ctx->channel_val[0]);
+  for(int c = 1; c<ctx->channel_count; c++){
+    if(channel_fresh(c)){
+      log_write(REC_ANCHOR | REC_CHANNEL | c, ctx->channel_val[c]);
+    }
+  }
+  ctx->rom_last_time = now;
+  ctx->rom_anchor_count = ctx->rom_anchor_count + 1;
+  //restart the adaptive sampling window from these values
+  for(int c = 0; c<ctx->channel_count; c++){
+    ctx->rom_last_val[c] = ctx->channel_val[c];
+  }
+  ctx->rom_ticks = 0;
+  ctx->rom_sample_delay = sample_next_delay(ctx->rom_due, ctx->rom_sample_delay, ctx->rom_min_delay, ctx->rom_delay);
+  ctx->rom_due = SAMPLE_NONE;
 }
 /**
  * Read all data from memeory. 
  * Once the data has been read in, reset all
  * memeory locations using reset_mem().
+ *
+ * run when the host sends its time (see
+ * text_command()), not just because the
+ * port was opened. this only starts it, the
+ * records go out READ_CHUNK per loop from
+ * read_step(), so the sensors, alarms and
+ * commands keep running. nothing is saved
+ * until the log has gone, since it is
+ * cleared after.
  */
 void mem_read(){
-  alert_led(memory_full_pin);
-  //wait until a Serial connection is made
-  if(Serial){ 
-    digitalWrite(memory_full_pin,LOW);
-    reset_fade();
-    readData();
-    reset_mem();
+  if(ctx->read_running){
+    return;
   }
+  reset_fade();
+  //a hang before the last restart is reported first
+  watch_report();
+  read_begin();
+  ctx->read_next = 0;
+  ctx->read_running = 1;
+}
+/**
+ * decides if sensor data should be saved on this tick.
+ *
+ * a reading on any channel that has drifted rom_tolerance
+ * or more from the last saved value is saved once rom_min_delay
+ * has gone by, and the save interval is halved (down to
+ * rom_min_delay) so a changing signal is followed closely. if
+ * the interval runs out while the reading stayed inside the
+ * tolerance, it is saved and the interval is doubled (up to
+ * rom_delay) so a flat signal uses few addresses. the interval
+ * only changes once mem_write() has saved the sample.
+ *
+ * holding each saved value until the next one rebuilds the
+ * recorded trace to within rom_tolerance of what the sensor
+ * read, apart from at most rom_min_delay ticks after each change
+ * (see Sampling.h, checked by tools/sample_check.cpp).
+ */
+int rom_sample_due(){
+  int drifted = 0;
+  for(int c = 0; c<ctx->channel_count; c++){
+    if(abs(ctx->channel_val[c] - ctx->rom_last_val[c]) >= ctx->rom_tolerance){
+      drifted = 1;
+    }
+  }
+  ctx->rom_due = sample_due(drifted, ctx->rom_ticks, ctx->rom_sample_delay, ctx->rom_min_delay);
+  return ctx->rom_due;
+}
+/**
+ * write the full time as an anchor so the
+ * sample deltas that follow can be turned back
+ * into absolute time by the host.
+ */
+void write_anchor(unsigned long anchor_time){
+  byte header = REC_ANCHOR;
+  if(ctx->time_synced){
+    header |= REC_SYNCED;
+  }
+  for(int j = 0; j<ANCHOR_BYTES; j++){
+    log_write(header | j, (anchor_time >> (8*(ANCHOR_BYTES-1-j))) & 0xFF);
+  }
+  ctx->rom_last_time = anchor_time;
+  ctx->rom_anchor_count = 0;
+}
+/**
+ * write one record to the next free slot.
+ * the queue programs bytes in order and the
+ * check byte is queued last so a record cut
+ * short by a power loss never looks valid.
+ */
+void log_write(byte header, byte data){
+  unsigned long addr = ctx->address_val * REC_SIZE;
+  unsigned int seq = ctx->log_base + ctx->address_val;
+  ctx->log_store->write(addr, header);
+  ctx->log_store->write(addr + 1, data);
+  ctx->log_store->write(addr + 2, seq & 0xFF);
+  ctx->log_store->write(addr + 3, log_crc(seq, header, data));
+  ctx->address_val = ctx->address_val + 1;
+}
+/**
+ * check byte over the full sequence number
+ * and the contents of a record
+ */
+byte log_crc(unsigned int seq, byte header, byte data){
+  byte crc = 0;
+  crc = _crc8_ccitt_update(crc, seq & 0xFF);
+  crc = _crc8_ccitt_update(crc, seq >> 8);
+  crc = _crc8_ccitt_update(crc, header);
+  return _crc8_ccitt_update(crc, data);
+}
+/**
+ * a slot is valid when it holds the sequence
+ * number expected at that position and its
+ * check byte matches. blank and torn slots
+ * fail one of the two.
+ */
+int log_valid(long slot){
+  unsigned long addr = slot * REC_SIZE;
+  unsigned int seq = ctx->log_base + slot;
+  byte header = ctx->log_store->read(addr);
+  byte data = ctx->log_store->read(addr + 1);
+  return header != LOG_BLANK
+      && ctx->log_store->read(addr + 2) == (seq & 0xFF)
+      && ctx->log_store->read(addr + 3) == log_crc(seq, header, data);
+}
+/**
+ * a slot nothing has been written to
+ */
+int log_blank(long slot){
+  for(int j = 0; j<REC_SIZE; j++){
+    if(ctx->log_store->read(slot*REC_SIZE + j) != LOG_BLANK){
+      return 0;
+    }
+  }
+  return 1;
+}
+/**
+ * records are always written in order from slot 0
+ * and every slot past the last record is blank, so
+ * the used slots form a single run at the start.
+ * a binary search finds the first blank slot in
+ * about log2(log_slots) slot reads.
+ *
+ * a record cut short by a power loss counts as
+ * used, since flash can't be written over without
+ * erasing a whole block. it is skipped and left
+ * out when the log is read.
+ */
+long log_find_head(){
+  long low = 0;
+  long high = ctx->log_slots;
+  while(low < high){
+    long mid = (low + high) / 2;
+    if(!log_blank(mid)){
+      low = mid + 1;
+    }else{
+      high = mid;
+    }
+  }
+  return low;
+}
+/**
+ * save the starting sequence number and flags
+ * in the header at the end of the storage
+ */
+void log_write_header(byte flags){
+  byte crc = log_crc(ctx->log_base, flags, 0);
+  ctx->log_store->erase(ctx->log_header, ctx->log_header + LOG_HEADER_SIZE);
+  ctx->log_store->write(ctx->log_header, ctx->log_base & 0xFF);
+  ctx->log_store->write(ctx->log_header + 1, ctx->log_base >> 8);
+  ctx->log_store->write(ctx->log_header + 2, flags);
+  ctx->log_store->write(ctx->log_header + 3, crc);
+}
+/**
+ * find where the recording left off after
+ * a restart. a damaged header or a clear that
+ * was cut short is finished here before
+ * looking for the end of the log.
+ *
+ * used in Setup();
+ */
+void log_recover(){
+  //the header gets a block to itself so erasing it leaves the records alone
+  unsigned long header_span = max((unsigned long)ctx->log_store->blockSize(), (unsigned long)LOG_HEADER_SIZE);
+  ctx->log_header = ctx->log_store->size() - header_span;
+  ctx->log_slots = ctx->log_header / REC_SIZE;
+  ctx->log_base = ctx->log_store->read(ctx->log_header) | (ctx->log_store->read(ctx->log_header + 1) << 8);
+  byte flags = ctx->log_store->read(ctx->log_header + 2);
+  if(ctx->log_store->read(ctx->log_header + 3) != log_crc(ctx->log_base, flags, 0) || (flags & LOG_CLEARING)){
+    log_write_header(LOG_CLEARING);
+    clearData(ctx->log_slots);
+    log_write_header(0);
+  }
+  ctx->address_val = log_find_head();
+  //the first record after a restart is always an anchor
+  ctx->control_val = (ctx->address_val + ANCHOR_BYTES + 1 > ctx->log_slots) ? READ : WRITE;
 }
 
 /***************************
@@ -644,6 +1794,8 @@ void mem_read(){
  * 
  * CONTENTS:
  *   void increment_timer()
+ *   unsigned long now_seconds()
+ *   void sync_time(unsigned long)
  ***************************/
 /**
  * timer that keeps relative time for
@@ -651,12 +1803,221 @@ void mem_read(){
  */
 void increment_timer(){
   //increment global timer and action timer
-  timer=timer + 1;
-  action_timer = action_timer +1 ;
+  ctx->timer=ctx->timer + 1;
+  ctx->action_timer = ctx->action_timer +1 ;
+  if(ctx->rom_ticks < sample_tick_limit(ctx->rom_min_delay, ctx->rom_delay)){
+    ctx->rom_ticks = ctx->rom_ticks + 1;
+  }
   //unlock timer if necessary
   check_sound_lock();
-  if(timer>=1000){
-    timer = 0;
+  if(ctx->timer>=1000){
+    ctx->timer = 0;
+  }
+}
+/**
+ * current time in seconds. this is host time
+ * once sync_time() has run, otherwise uptime.
+ */
+unsigned long now_seconds(){
+  return ctx->time_offset + millis()/1000;
+}
+/**
+ * line the clock up with the host's time
+ * (in seconds). the next saved sample starts
+ * with a new anchor.
+ */
+void sync_time(unsigned long host_time){
+  ctx->time_offset = host_time - millis()/1000;
+  ctx->time_synced = 1;
+  ctx->rom_anchor_count = ANCHOR_PERIOD;
+}
+
+/***************************
+ * COMMAND FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void poll_commands()
+ *   void text_command(uint8_t)
+ *   void run_command(command*)
+ ***************************/
+/**
+ * handle whatever the host has sent since the
+ * last loop, at most CMD_MAX_BYTES of it, without
+ * waiting for the rest of a request. binary
+ * requests (see Command.h) go to run_command(),
+ * anything else to text_command().
+ */
+void poll_commands(){
+  for(int i = 0; i<CMD_MAX_BYTES && Serial.available(); i++){
+    uint8_t b = Serial.read();
+    int fed = command_feed(&ctx->cmd_in, b, millis());
+    if(fed == CMD_READY){
+      run_command(&ctx->cmd_in);
+    }else if(fed == CMD_TEXT){
+      text_command(b);
+    }
+  }
+}
+/**
+ * one letter commands from the Serial monitor:
+ *   S  channel statistics (see print_stats())
+ *   H  DHT22 read history (see print_dht_health())
+ *   M  memory use (see print_memory())
+ *   T  followed by the host's time in seconds and
+ *      a newline. the handshake the host sends when
+ *      it connects: the clock is lined up with it
+ *      and the log is sent over the next loops, then
+ *      cleared (see mem_read())
+ */
+void text_command(uint8_t b){
+  if(ctx->sync_digits >= 0){
+    if(b >= '0' && b <= '9'){
+      ctx->sync_value = ctx->sync_value*10 + (b - '0');
+      ctx->sync_digits++;
+      return;
+    }
+    int digits = ctx->sync_digits;
+    ctx->sync_digits = -1;
+    if(digits && (b == '\n' || b == '\r')){
+      sync_time(ctx->sync_value);
+      mem_read();
+      return;
+    }
+  }
+  switch(b){
+  case 'S':
+    print_stats();
+    break;
+  case 'H':
+    print_dht_health();
+    break;
+  case 'M':
+    print_memory();
+    break;
+  case 'T':
+    ctx->sync_digits = 0;
+    ctx->sync_value = 0;
+    break;
+  }
+}
+/**
+ * carry out a binary request and answer it
+ * (see Command.h for what each one holds)
+ */
+void run_command(command *c){
+  uint8_t out[CMD_MAX_PAYLOAD];
+  uint8_t n = 0;
+  uint8_t error = 0;
+  int channel = c->len ? c->payload[0] : 0;
+
+  switch(c->cmd){
+  case CMD_GET_CHANNEL:
+    if(c->len != 1){
+      error = CMD_ERR_LENGTH;
+    }else if(channel >= ctx->channel_count){
+      error = CMD_ERR_RANGE;
+    }else{
+      out[n++] = channel;
+      out[n++] = ctx->channel_val[channel];
+      out[n++] = channel_fresh(channel);
+      n = command_put_word(out, n, min((millis() - ctx->channel_time[channel]) / 1000, 0xFFFFUL));
+    }
+    break;
+  case CMD_GET_COUNTERS:
+    if(c->len != 0){
+      error = CMD_ERR_LENGTH;
+      break;
+    }
+    n = command_put_word(out, n, events.overflows());
+    n = command_put_long(out, n, ctx->address_val);
+    n = command_put_long(out, n, ctx->log_slots - ctx->address_val);
+    for(int i = 0; i<ctx->dht_count; i++){
+      dht22_health *h = &ctx->dht_health[i];
+      n = command_put_word(out, n, h->good);
+      n = command_put_word(out, n, h->timeouts);
+      n = command_put_word(out, n, h->checksums);
+      n = command_put_word(out, n, h->stuck);
+      out[n++] = h->failures;
+    }
+    break;
+  case CMD_GET_STATS:
+    if(c->len != 1){
+      error = CMD_ERR_LENGTH;
+    }else if(channel >= ctx->channel_count){
+      error = CMD_ERR_RANGE;
+    }else{
+      stats *st = &ctx->channel_stats[channel];
+      out[n++] = channel;
+      n = command_put_long(out, n, st->n);
+      n = command_put_word(out, n, st->mean * 16);
+      n = command_put_word(out, n, sqrt(stats_variance(st)) * 16);
+      n = command_put_word(out, n, stats_average(st) * 16);
+      out[n++] = st->flags;
+    }
+    break;
+  case CMD_SET_ALARM:
+    if(c->len != 3){
+      error = CMD_ERR_LENGTH;
+      break;
+    }
+    switch(c->payload[0]){
+    case ALARM_HUMIDITY:
+      set_humidity_alarm(command_word(c, 1));
+      break;
+    case ALARM_RANGE:
+      set_range_alarm(command_word(c, 1));
+      break;
+    case ALARM_DEW:
+      set_dew_alarm(command_word(c, 1));
+      break;
+    case ALARM_HEAT:
+      set_heat_alarm(command_word(c, 1));
+      break;
+    default:
+      error = CMD_ERR_RANGE;
+      break;
+    }
+    memcpy(out, c->payload, 3);
+    n = 3;
+    break;
+  case CMD_EXPORT:
+    if(c->len != 5){
+      error = CMD_ERR_LENGTH;
+      break;
+    }
+    {
+      //records go out as stored, nothing is cleared
+      unsigned long first = command_long(c, 0);
+      if(first > (unsigned long)ctx->address_val){
+        error = CMD_ERR_RANGE;
+        break;
+      }
+      uint8_t count = min(min(c->payload[4], EXPORT_MAX_RECORDS), ctx->address_val - first);
+      n = command_put_long(out, n, first);
+      out[n++] = count;
+      for(unsigned long b = first*REC_SIZE; b<(first + count)*REC_SIZE; b++){
+        out[n++] = ctx->log_store->read(b);
+      }
+    }
+    break;
+  case CMD_GET_MEMORY:
+    if(c->len != 0){
+      error = CMD_ERR_LENGTH;
+      break;
+    }
+    n = command_put_word(out, n, static_memory());
+    n = command_put_word(out, n, free_memory());
+    n = command_put_word(out, n, stack_unused());
+    break;
+  default:
+    error = CMD_ERR_UNKNOWN;
+    break;
+  }
+
+  if(error){
+    command_error(c->cmd, error);
+  }else{
+    command_answer(c->cmd, out, n);
   }
 }
 
@@ -0,0 +1,83 @@
+/*####################################################################
+ * FILE: Sampling.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: The rule that decides when a sample is saved to the log and
+ *          how the time between saves adapts. Kept apart from R24U.h so
+ *          the same rule can be run on a computer against recorded
+ *          readings (see tools/sample_check.cpp).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Times are in loop ticks. A save is due when a reading has
+ *        drifted the tolerance or more from the last saved value and at
+ *        least min_delay ticks have gone by, or when the current
+ *        interval has run out. A drift save halves the interval (down
+ *        to min_delay), a save on a flat signal doubles it (up to
+ *        max_delay).
+ *
+ *        So holding each saved value until the next one is never off
+ *        by the tolerance or more for longer than min_delay ticks.
+ *
+ *        The ticks since the last save must be counted up to the
+ *        larger of min_delay and max_delay (see sample_tick_limit()),
+ *        so a max_delay set below min_delay still lets saves happen.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+//why a sample is due
+#define SAMPLE_NONE 0
+#define SAMPLE_DRIFT 1 //a reading moved the tolerance or more
+#define SAMPLE_STABLE 2 //the interval ran out
+
+/***************************
+ * SAMPLING FUNCTION(S)
+ *
+ * CONTENTS:
+ *   int sample_due(int, int, int, int)
+ *   int sample_next_delay(int, int, int, int)
+ *   int sample_tick_limit(int, int)
+ ***************************/
+/**
+ * whether a sample is due, and why.
+ * drifted is true if any reading is the
+ * tolerance or more from its saved value.
+ */
+inline int sample_due(int drifted, int ticks, int sample_delay, int min_delay){
+  if(drifted && ticks >= min_delay){
+    return SAMPLE_DRIFT;
+  }
+  if(ticks >= sample_delay){
+    return SAMPLE_STABLE;
+  }
+  return SAMPLE_NONE;
+}
+/**
+ * the interval to use once a sample that
+ * was due for this reason has been saved
+ */
+inline int sample_next_delay(int reason, int sample_delay, int min_delay, int max_delay){
+  if(reason == SAMPLE_DRIFT){
+    return sample_delay/2 > min_delay ? sample_delay/2 : min_delay;
+  }
+  if(reason == SAMPLE_STABLE){
+    return sample_delay*2 < max_delay ? sample_delay*2 : max_delay;
+  }
+  return sample_delay;
+}
+/**
+ * the most ticks worth counting between
+ * saves, every interval fits below it
+ */
+inline int sample_tick_limit(int min_delay, int max_delay){
+  return min_delay > max_delay ? min_delay : max_delay;
+}
+
+#endif // SAMPLING_H
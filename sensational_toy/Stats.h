@@ -0,0 +1,149 @@
+/*####################################################################
+ * FILE: Stats.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Running statistics for a stream of sensor readings, kept in
+ *          a fixed amount of memory no matter how many readings go by:
+ *          mean and variance (Welford's method), a moving average and
+ *          a small histogram. Also flags readings that look wrong,
+ *          either far from the usual values or stuck on one value.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Readings are 0 - 255, the same as a log channel.
+ *
+ *        A reading is a spike when it is more than z standard
+ *        deviations from the mean. This is checked as
+ *        (x - mean)^2 > z^2 * variance so no square root is needed.
+ *        The variance is taken as at least STATS_MIN_VARIANCE, or a
+ *        reading that has been flat for a while would count as a
+ *        spike when it moves by a few steps.
+ *
+ *        Nothing here uses the heap, a stats struct is all there is.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <inttypes.h>
+#include <string.h>
+
+/***************************
+ * CONSTANT DEFINITIONS
+ ***************************/
+#define STATS_BUCKETS 8 //histogram buckets over 0 - 255
+#define STATS_BUCKET_SHIFT 5 //reading >> this is its bucket
+#define STATS_EWMA_SHIFT 4 //moving average weight is 1/16
+#define STATS_FRACTION 8 //fraction bits of the moving average
+#define STATS_MIN_SAMPLES 30 //readings needed before spikes are flagged
+#define STATS_MIN_VARIANCE 4.0f //smallest spread a spike is measured against (2 steps)
+
+//anomaly flags
+#define STATS_SPIKE 0x01 //far from the mean
+#define STATS_STUCK 0x02 //same value for too long
+
+/***************************
+ * STATS
+ ***************************/
+struct stats
+{
+  unsigned long n; //readings so far
+  float mean;
+  float m2; //sum of squared distances from the mean
+  long ewma; //moving average, STATS_FRACTION bits after the point
+  uint8_t last; //previous reading
+  uint8_t flags; //anomaly flags of the last reading
+  unsigned int same; //readings in a row equal to last
+  unsigned int bucket[STATS_BUCKETS];
+};
+
+/***************************
+ * STATS FUNCTION(S)
+ *
+ * CONTENTS:
+ *   void stats_reset(stats*)
+ *   uint8_t stats_add(stats*, uint8_t, uint8_t, unsigned int)
+ *   float stats_variance(stats*)
+ *   float stats_average(stats*)
+ ***************************/
+/**
+ * forget every reading
+ */
+inline void stats_reset(stats *s){
+  memset(s, 0, sizeof(stats));
+}
+/**
+ * add a reading and return its anomaly flags.
+ * z is how many standard deviations count as
+ * a spike, stuck how many equal readings in a
+ * row count as stuck. 0 turns either off.
+ */
+inline uint8_t stats_add(stats *s, uint8_t x, uint8_t z, unsigned int stuck){
+  uint8_t flags = 0;
+
+  //compare against the readings before this one
+  if(z && s->n >= STATS_MIN_SAMPLES){
+    float d = x - s->mean;
+    //readings are whole numbers and real ones wander a
+    //little, so a flat signal is never taken to spread
+    //less than a couple of steps
+    float variance = max(s->m2 / (s->n - 1), STATS_MIN_VARIANCE);
+    if(d*d > (float)z*z*variance){
+      flags |= STATS_SPIKE;
+    }
+  }
+  if(s->n && x == s->last){
+    if(s->same < 0xFFFF){
+      s->same++;
+    }
+  }else{
+    s->same = 0;
+  }
+  if(stuck && s->same >= stuck){
+    flags |= STATS_STUCK;
+  }
+
+  //Welford's method keeps the mean and variance
+  //accurate without storing any readings
+  s->n++;
+  float delta = x - s->mean;
+  s->mean += delta / s->n;
+  s->m2 += delta * (x - s->mean);
+
+  if(s->n == 1){
+    s->ewma = (long)x << STATS_FRACTION;
+  }else{
+    s->ewma += (((long)x << STATS_FRACTION) - s->ewma) >> STATS_EWMA_SHIFT;
+  }
+
+  //when a bucket is full every bucket is halved,
+  //which keeps the shape and favours newer readings
+  uint8_t b = x >> STATS_BUCKET_SHIFT;
+  if(s->bucket[b] == 0xFFFF){
+    for(uint8_t i = 0; i<STATS_BUCKETS; i++){
+      s->bucket[i] >>= 1;
+    }
+  }
+  s->bucket[b]++;
+
+  s->last = x;
+  s->flags = flags;
+  return flags;
+}
+/**
+ * variance of every reading so far
+ */
+inline float stats_variance(stats *s){
+  return s->n > 1 ? s->m2 / (s->n - 1) : 0;
+}
+/**
+ * moving average, weighted towards the
+ * newest readings
+ */
+inline float stats_average(stats *s){
+  return s->ewma / (float)(1 << STATS_FRACTION);
+}
+
+#endif // STATS_H
@@ -59,30 +59,45 @@ typedef struct {
 	static const uint8_t D3=7;
 	static const uint8_t P3=8;
 
+	//constexpr where the compiler has it, so the tables below
+	//can be used where a constant is needed (see versalinoPin())
+#if __cplusplus >= 201103L
+	#define VERSALINO_TABLE constexpr
+#else
+	#define VERSALINO_TABLE const
+#endif
+
 	//---------------Multi-BUS Identifiers------------------------
-	static const VersalinoPIN PINS[] =
-	{(VersalinoPIN) {A0, A3},
-	 (VersalinoPIN) {A1, A4},
-	 (VersalinoPIN) {A2, A5},
-	 (VersalinoPIN) {2,  7},
-	 (VersalinoPIN) {3,  9},
-	 (VersalinoPIN) {4,  8},
-	 (VersalinoPIN) {5,  10},
-	 (VersalinoPIN) {13, 12},
-	 (VersalinoPIN) {6,  11}
+	static VERSALINO_TABLE VersalinoPIN PINS[] =
+	{{A0, A3},
+	 {A1, A4},
+	 {A2, A5},
+	 {2,  7},
+	 {3,  9},
+	 {4,  8},
+	 {5,  10},
+	 {13, 12},
+	 {6,  11}
 	};
 
 	//---------------Full BUS Layouts
-	static const VersalinoBUS BUSA={ 'A',
+	static VERSALINO_TABLE VersalinoBUS BUSA={ 'A',
 									{PINS[AN0].BUSA,PINS[AN1].BUSA,PINS[AN2].BUSA,PINS[D1].BUSA,PINS[P1].BUSA,PINS[D2].BUSA,PINS[P2].BUSA,PINS[D3].BUSA,PINS[P3].BUSA},
 									 PINS[AN0].BUSA,PINS[AN1].BUSA,PINS[AN2].BUSA,PINS[D1].BUSA,PINS[P1].BUSA,PINS[D2].BUSA,PINS[P2].BUSA,PINS[D3].BUSA,PINS[P3].BUSA
 								   };
 
-	static const VersalinoBUS BUSB={ 'B',
+	static VERSALINO_TABLE VersalinoBUS BUSB={ 'B',
 									{PINS[AN0].BUSB,PINS[AN1].BUSB,PINS[AN2].BUSB,PINS[D1].BUSB,PINS[P1].BUSB,PINS[D2].BUSB,PINS[P2].BUSB,PINS[D3].BUSB,PINS[P3].BUSB},
 									 PINS[AN0].BUSB,PINS[AN1].BUSB,PINS[AN2].BUSB,PINS[D1].BUSB,PINS[P1].BUSB,PINS[D2].BUSB,PINS[P2].BUSB,PINS[D3].BUSB,PINS[P3].BUSB
 								   };
 
-
+#if __cplusplus >= 201103L
+	//---------------Compile time lookup--------------------------
+	//the Arduino pin of a bus pin, e.g. FastPin<versalinoPin(BUSA, D1)>
+	constexpr uint8_t versalinoPin(VersalinoBUS bus, uint8_t id)
+	{
+		return bus.PINS[id];
+	}
+#endif
 
 #endif // VERSALINO_H
@@ -52,6 +52,18 @@
 #include "Versalino.h"
 #include <inttypes.h>
 
+#define DHT22_START_US 2000 //how long the data line is held low to wake the sensor
+#define DHT22_PERIOD_MS 2000 //the sensor can't be read more often than this
+
+//results of finish()
+#define DHT22_OK 0
+#define DHT22_ERROR_CHECKSUM -1 //the reply was garbled
+#define DHT22_ERROR_TIMEOUT -2 //the sensor stopped answering, or never did
+#define DHT22_ERROR_BUS_STUCK -3 //something held the data line low
+
+#define DHT22_RETRIES 2 //failed reads in a row that are retried at the normal period
+#define DHT22_MAX_BACKOFF 32 //longest wait after more failures, in periods
+
 
 class dht22
 {
@@ -83,13 +95,166 @@ class dht22
 	double dewPoint();
 	double dewPointFast();
 
+	//-------split read, so several sensors can share one start pulse wait
+	int pin();//Arduino pin of the sensor, after the VersalinoBUS lookup if one is set
+	void start();//pulls the data line low to wake the sensor
+	int finish();//at least DHT22_START_US after start(), releases the line and reads the reply, returns DHT22_OK or an error
+
 
 	private:
 	VersalinoBUS _myBUS;
 	bool _BUSenabled;
 	int _sensorPin;//defaults to pin 2
 
+	static int waitFor(volatile uint8_t *in, uint8_t mask, uint8_t level, unsigned int timeout);//returns loops, not microseconds
+
 };
 
+//read history of one sensor, kept beside it so a sensor that keeps
+//failing is read less and less often instead of every period
+struct dht22_health
+{
+	unsigned int good;
+	unsigned int timeouts;
+	unsigned int checksums;
+	unsigned int stuck;
+	uint8_t failures;//failed reads in a row
+	unsigned long next;//millis() when the sensor may be read again
+	unsigned long last_good;//millis() of the last good read
+
+	bool due(unsigned long now);//true once the backoff has run out
+	void record(int status, unsigned long now);//count a read and plan the next one
+	unsigned long age(unsigned long now);//milliseconds since the last good read
+};
+
+int dht22::pin()
+{
+	return _BUSenabled ? _myBUS.PINS[_sensorPin] : _sensorPin;
+}
+
+void dht22::start()
+{
+	int p = pin();
+	digitalWrite(p, LOW);
+	pinMode(p, OUTPUT);
+}
+
+int dht22::finish()
+{
+	uint8_t bits[5] = {0, 0, 0, 0, 0};
+	int p = pin();
+	uint8_t mask = digitalPinToBitMask(p);
+	volatile uint8_t *in = portInputRegister(digitalPinToPort(p));
+	uint8_t oldSREG = SREG;
+	int status = DHT22_OK;
+
+	//the reply is timed by counting loops with interrupts off, since
+	//an interrupt (the LED timer, USB) in the middle of a bit stretches
+	//it past the threshold and garbles the reply. This takes about 5ms,
+	//so millis() falls behind by about 4ms per read, and other
+	//interrupts (a range echo) are answered late.
+	cli();
+
+	//release the line, the sensor answers with 80us low then 80us high.
+	//the sensor never holds the line low for more than 80us, so
+	//waiting longer than that for it to go high means it is stuck
+	pinMode(p, INPUT_PULLUP);
+	if (waitFor(in, mask, 0, 100) < 0)
+		status = DHT22_ERROR_TIMEOUT;
+	else if (waitFor(in, mask, mask, 100) < 0)
+		status = DHT22_ERROR_BUS_STUCK;
+	else if (waitFor(in, mask, 0, 100) < 0)
+		status = DHT22_ERROR_TIMEOUT;
+
+	//each bit is 50us low then 26us high for a 0 or 70us high for a 1,
+	//so a high that lasts longer than the low before it is a 1
+	for (int i = 0; i < 40 && status == DHT22_OK; i++)
+	{
+		int low = waitFor(in, mask, mask, 100);
+		if (low < 0)
+		{
+			status = DHT22_ERROR_BUS_STUCK;
+			break;
+		}
+		int high = waitFor(in, mask, 0, 100);
+		if (high < 0)
+		{
+			status = DHT22_ERROR_TIMEOUT;
+			break;
+		}
+		bits[i / 8] = (bits[i / 8] << 1) | (high > low);
+	}
+
+	SREG = oldSREG;
+	if (status != DHT22_OK)
+		return status;
+
+	if (bits[4] != (uint8_t)(bits[0] + bits[1] + bits[2] + bits[3]))
+		return DHT22_ERROR_CHECKSUM;
+
+	humidity = ((bits[0] << 8) | bits[1]) * 0.1;
+	temperature = (((bits[2] & 0x7F) << 8) | bits[3]) * 0.1;
+	if (bits[2] & 0x80)
+		temperature = -temperature;
+	return DHT22_OK;
+}
+
+//waits for the line to reach level, returns the loops it took or -1 on timeout.
+//micros() can't be used with interrupts off, so the timeout is in loops:
+//a loop takes at least 4 cycles, so this waits at least timeout microseconds
+int dht22::waitFor(volatile uint8_t *in, uint8_t mask, uint8_t level, unsigned int timeout)
+{
+	unsigned int limit = microsecondsToClockCycles(timeout) / 4;
+	unsigned int loops = 0;
+	while ((*in & mask) != level)
+	{
+		if (++loops > limit)
+			return -1;
+	}
+	return loops;
+}
+
+bool dht22_health::due(unsigned long now)
+{
+	return (long)(now - next) >= 0;
+}
+
+//after DHT22_RETRIES failures in a row the wait doubles with every
+//failure, up to DHT22_MAX_BACKOFF periods
+void dht22_health::record(int status, unsigned long now)
+{
+	unsigned long wait = DHT22_PERIOD_MS;
+	switch (status)
+	{
+	case DHT22_OK:
+		good++;
+		failures = 0;
+		last_good = now;
+		break;
+	case DHT22_ERROR_CHECKSUM:
+		checksums++;
+		break;
+	case DHT22_ERROR_BUS_STUCK:
+		stuck++;
+		break;
+	default:
+		timeouts++;
+		break;
+	}
+	if (status != DHT22_OK)
+	{
+		if (failures < 0xFF)
+			failures++;
+		for (uint8_t i = DHT22_RETRIES; i < failures && wait < (unsigned long)DHT22_PERIOD_MS * DHT22_MAX_BACKOFF; i++)
+			wait *= 2;
+	}
+	next = now + wait;
+}
+
+unsigned long dht22_health::age(unsigned long now)
+{
+	return now - last_good;
+}
+
 
 #endif // DHT11_H
@@ -9,6 +9,13 @@
  * HISTORY:
 #######################################################################*/
 
+/***************************
+ * BUILD OPTIONS
+ ***************************/
+//uncomment to time each part of the sketch at startup
+//and send the results over Serial (see Benchmark.h)
+//#define R24U_BENCHMARK
+
 /***************************
  * INCLUDED FILES
  ***************************/
@@ -16,7 +23,18 @@
 #include "EEPROM.h"
 #include "SFEbarGraph.h"
 #include "SPI.h"
+#include "LogStorage.h"
+#include "Sampling.h"
 #include "dht22.h"
+#include "Climate.h"
+#include "Stats.h"
+#include "FastPin.h"
+#include "LedFx.h"
+#include "LoopWatch.h"
+#include "EventRing.h"
+#include "MemWatch.h"
+#include "Command.h"
+#include <util/crc16.h>
 //Soft serial library used to send serial commands on pin 2 instead of regular serial pin.
 #include <SoftwareSerial.h>
 
@@ -28,59 +46,100 @@
  */
 #include "R24U.h"
 
+#ifdef R24U_BENCHMARK
+#include "Benchmark.h"
+#endif
+
 /*********************************
  *         BEGIN PROGRAM
  *********************************/
 void setup(){
   //init bargraph
-  BG.begin();
+  setup_bargraph();
   
-  //set address_val to currently saved value
-  address_val = EEPROM.read(ADDRESSBIT);
+  //pick up recording where it left off
+  log_recover();
   
   Serial.begin(9600);
   
+#ifdef R24U_BENCHMARK
+  //wait for the Serial monitor before timing anything
+  while(!Serial);
+  run_benchmarks();
+#endif
+  
   /*SETUP FUNCTIONS*/
   setup_voicebox();
   setup_leds();
   setup_ranger();
-  DHT22.attach(DHTPIN);
+  //sensors are read together by acquire_sensors(), more can
+  //be added on either Versalino bus, e.g.
+  //  add_dht_sensor(D1, BUSB);
+  //  add_analog_sensor(BUSA.AN0);
+  add_dht_sensor(ctx->DHTPIN);
+  //a DHT22's dew point, heat index or absolute
+  //humidity can be saved as well, e.g.
+  //  add_climate_channel(0, CLIMATE_DEW);
   
   //rest for a sec before diving in to loop
   delay(1000);
+  
+  //restart if the loop ever hangs (see LoopWatch.h)
+  watch_begin();
 }
 
 void loop(){
+  //time the last loop and hold off the watchdog
+  watch_loop();
+  //read all sensors when they are due
+  watch_task(WATCH_SENSORS);
+  acquire_sensors();
+  //alarm on readings that look wrong
+  check_anomalies();
   //check humidity and update bargraph
+  watch_task(WATCH_BARGRAPH);
   activate_bargraph();
+  watch_task(WATCH_C0);
   get_C0_value();
   //check range sensor values
+  watch_task(WATCH_RANGE);
   find_range();
-  //set the control value to whatever is stored in the control mem address
-  control_val = EEPROM.read(CONTROLBIT);
+  //handle echoes and other events from interrupts
+  watch_task(WATCH_EVENTS);
+  drain_events();
+  //answer the host, the log is sent once it
+  //sends its time (see text_command())
+  watch_task(WATCH_COMMANDS);
+  poll_commands();
   /*
-   * If the serial monitor is closed, and the control value says to write
-   * and the timer is at the chosen interval (see timing variables)
-   * then write humidity data to memory
+   * If the control value says to write
+   * and the sensor data is due to be saved (see rom_sample_due())
+   * then write humidity data to memory, whether or not
+   * the serial monitor is open
    */
-  if(!Serial && control_val==WRITE && timer%rom_delay==0){
+  if(ctx->control_val==WRITE && rom_sample_due()){
+     watch_task(WATCH_LOG_WRITE);
      mem_write();
    }
    /*
-   * else if the control mem address stores a read value
-   * or the serial monitor is open, then output data.
-   *
-   * the serial monitor option is there in case
-   * someone would like to read data before all 510s
-   * memory address have been filled up, which may take
-   * a long time. 
+   * else if the log is full (control value says to read)
+   * fade the memory led until the host connects
+   * and takes the data.
    */
-   else if(control_val == READ || Serial){
-     mem_read();
+   else if(ctx->control_val == READ && !ctx->read_running){
+     alert_led(ctx->memory_full_pin);
    }
+  //send the log a few records at a time once the host asked for it
+  watch_task(WATCH_LOG_READ);
+  read_step();
+  //clear the old log a little at a time after it was sent
+  watch_task(WATCH_LOG_CLEAR);
+  clear_step();
    
+  watch_task(WATCH_TIMER);
   increment_timer();
-  delay(global_delay);
+  watch_task(WATCH_DELAY);
+  delay(ctx->global_delay);
 }
 
 
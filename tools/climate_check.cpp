@@ -0,0 +1,144 @@
+/*####################################################################
+ * FILE: climate_check.cpp
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Runs the table based dew point, heat index and absolute
+ *          humidity (sensational_toy/Climate.h) on a computer at every
+ *          reading a DHT22 can give, and checks them against the
+ *          formulas they stand in for, within the bounds Climate.h
+ *          promises.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * USAGE: g++ -I tools/host -I sensational_toy -o climate_check tools/climate_check.cpp
+ *        ./climate_check
+ *
+ *        Prints the worst error of each result and where it is, and
+ *        exits with 1 if any is past its bound.
+ *
+ * NOTES: The dew point is compared with dht22::dewPoint(), copied
+ *        here, the absolute humidity with the same Goff-Gratch
+ *        pressure and the heat index with the NOAA (Rothfusz) formula.
+ *        Readings go in in order, as they would from a sensor, so the
+ *        dew point search starts from the last entry like on the board.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+#define constrain(x, low, high) ((x)<(low) ? (low) : ((x)>(high) ? (high) : (x)))
+
+#include "Climate.h"
+
+#define DEW_BOUND 0.25 //C
+#define ABS_BOUND 0.2 //g/m3
+#define HEAT_BOUND 0.4 //C, from HEAT_FROM to HEAT_TO
+#define HEAT_FROM 280 //tenths C, below it the NOAA formula jumps
+#define HEAT_TO 460 //tenths C, past it the table keeps its last row
+#define DEW_FLOOR -40.0 //C, the table's lowest dew point
+
+struct worst
+{
+  double error;
+  int temp10;
+  int rh10;
+};
+
+/**
+ * saturation vapour pressure (Pa), Goff-Gratch
+ * as in dht22::dewPoint()
+ */
+double saturation(double celsius){
+  double A0 = 373.15/(273.15 + celsius);
+  double SUM = -7.90298 * (A0-1);
+  SUM += 5.02808 * log10(A0);
+  SUM += -1.3816e-7 * (pow(10, (11.344*(1-1/A0)))-1);
+  SUM += 8.1328e-3 * (pow(10, (-3.49149*(A0-1)))-1);
+  SUM += log10(1013.246);
+  return pow(10, SUM) * 100;
+}
+/**
+ * dht22::dewPoint()
+ */
+double dew_point(double celsius, double humidity){
+  double VP = saturation(celsius) / 100000 * humidity;
+  double T = log(VP/0.61078);
+  return (241.88 * T) / (17.558-T);
+}
+/**
+ * NOAA heat index (Rothfusz with its
+ * adjustments), in and out in C
+ */
+double heat_index(double celsius, double humidity){
+  double T = celsius*9/5 + 32;
+  double hi = 0.5*(T + 61 + (T - 68)*1.2 + humidity*0.094);
+  if((hi + T)/2 >= 80){
+    hi = -42.379 + 2.04901523*T + 10.14333127*humidity - 0.22475541*T*humidity
+         - 0.00683783*T*T - 0.05481717*humidity*humidity + 0.00122874*T*T*humidity
+         + 0.00085282*T*humidity*humidity - 0.00000199*T*T*humidity*humidity;
+    if(humidity < 13 && T >= 80 && T <= 112){
+      hi -= ((13 - humidity)/4) * sqrt((17 - fabs(T - 95))/17);
+    }else if(humidity > 85 && T >= 80 && T <= 87){
+      hi += ((humidity - 85)/10) * ((87 - T)/5);
+    }
+  }
+  return (hi - 32)*5/9;
+}
+/**
+ * grams of water per cubic metre
+ */
+double abs_humidity(double celsius, double humidity){
+  return 2.1674 * saturation(celsius) * humidity / 100 / (celsius + 273.15);
+}
+
+void track(worst *w, double error, int temp10, int rh10){
+  if(error > w->error){
+    w->error = error;
+    w->temp10 = temp10;
+    w->rh10 = rh10;
+  }
+}
+
+int report(const char *name, const worst &w, double bound, const char *unit){
+  int ok = w.error <= bound;
+  printf("%-5s worst %.3f %s at %.1f C %.1f %%  (bound %.2f)  %s\n",
+         name, w.error, unit, w.temp10/10.0, w.rh10/10.0, bound, ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(){
+  worst dew = {0, 0, 0};
+  worst absolute = {0, 0, 0};
+  worst heat = {0, 0, 0};
+  climate result = {0, 0, 0, 0};
+
+  //every tenth the DHT22 reads, -40 to 60 C and 1 to 100 %
+  for(int t = -400; t<=600; t++){
+    for(int h = 10; h<=1000; h++){
+      climate_update(&result, t, h);
+      double celsius = t/10.0;
+      double humidity = h/10.0;
+
+      //the table stops at its lowest entry
+      double expect = dew_point(celsius, humidity);
+      if(expect > DEW_FLOOR){
+        track(&dew, fabs(result.dew10/10.0 - expect), t, h);
+      }
+      track(&absolute, fabs(result.abs10/10.0 - abs_humidity(celsius, humidity)), t, h);
+      if(t >= HEAT_FROM && t <= HEAT_TO){
+        track(&heat, fabs(result.heat10/10.0 - heat_index(celsius, humidity)), t, h);
+      }
+    }
+  }
+
+  int failed = 0;
+  failed |= report("dew", dew, DEW_BOUND, "C");
+  failed |= report("abs", absolute, ABS_BOUND, "g/m3");
+  failed |= report("heat", heat, HEAT_BOUND, "C");
+  return failed;
+}
@@ -0,0 +1,340 @@
+/*####################################################################
+ * FILE: fleet_sim.cpp
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Runs the sketch (R24U.h) for a whole fleet of simulated
+ *          devices at once on a computer, spread over a work stealing
+ *          thread pool, and reports how often they alarm and how long
+ *          their logs take to fill.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * USAGE: g++ -std=c++17 -O2 -pthread -Wno-narrowing -I tools/host \
+ *            -I sensational_toy -o fleet_sim tools/fleet_sim.cpp
+ *        ./fleet_sim [devices hours [threads]]
+ *
+ *        devices defaults to 2000 and hours (simulated time per
+ *        device) to 12. threads defaults to one per core.
+ *
+ *        Prints the settings, how long the run took, then per device
+ *        hour the humidity and anomaly alarms, the share of devices
+ *        that sounded each, and when the logs filled (min, median,
+ *        90th percentile, max) for the devices whose log filled.
+ *
+ * NOTES: Every device has its own device struct (set_device()), its
+ *        own log in RAM the size of the EEPROM log and its own clock
+ *        (host_us, see tools/host/Arduino.h). A device is one task:
+ *        its whole run is stepped on one thread, so it never shares
+ *        R24U_LOCAL state with another thread. Each worker takes
+ *        tasks from the back of its own queue and, once that is
+ *        empty, steals from the front of another worker's.
+ *
+ *        A step follows loop() with the settings setup() leaves,
+ *        plus set_anomaly_alarm(4, 0) so anomalies are counted too.
+ *        The DHT22's wire protocol isn't simulated: when a read is
+ *        due its result is put where dht22::finish() leaves it, from
+ *        a model of the room (a daily swing around a base humidity,
+ *        sensor noise, now and then a jump such as a door opening)
+ *        and of a flaky sensor on some devices. The range finder, C0
+ *        sensor, host commands and watchdog have nothing to do here
+ *        and are left out. Nothing reads the logs, so a full one
+ *        stays full.
+ *
+ *        Each device's model is seeded from its number, so a run
+ *        gives the same results with any number of threads.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "sensational_toy.ino"
+#include "host_libraries.h"
+
+#define FLEET_LOG_BYTES (E2END + 1 - EEPROM_RESERVED) //same as EEPROMStorage
+#define FLEET_DAY_MS 86400000.0
+
+/***************************
+ * RAM LOG
+ ***************************/
+class FleetStorage final : public LogStorage
+{
+  public:
+    FleetStorage() { memset(_bytes, LOG_BLANK, sizeof(_bytes)); }
+    uint32_t size() { return FLEET_LOG_BYTES; }
+    uint16_t blockSize() { return 1; }
+    uint8_t read(uint32_t address) { return _bytes[address]; }
+    void write(uint32_t address, uint8_t value) { _bytes[address] = value; }
+    void erase(uint32_t from, uint32_t to) { memset(_bytes + from, LOG_BLANK, to - from); }
+    void sync() {}
+
+  private:
+    uint8_t _bytes[FLEET_LOG_BYTES];
+};
+
+/***************************
+ * SIMULATED DEVICE
+ ***************************/
+struct fleet_device
+{
+  device state;
+  FleetStorage log;
+
+  //the room and the sensor
+  uint32_t seed; //random numbers for this device only
+  double base; //humidity the room swings around (%)
+  double swing; //size of the daily swing (%)
+  double phase; //where in the day the swing peaks (0 - 1)
+  double temperature; //C
+  double fail_rate; //share of reads that time out
+  double jump; //humidity added by the current jump (%)
+  unsigned long jump_end; //millis() the jump ends
+
+  //results
+  unsigned long humidity_alarms;
+  unsigned long anomaly_alarms;
+  long full_ms; //millis() the log filled, -1 if it didn't
+};
+
+/**
+ * next random number from 0 to 1 (xorshift32)
+ */
+double fleet_random(fleet_device *d){
+  d->seed ^= d->seed << 13;
+  d->seed ^= d->seed >> 17;
+  d->seed ^= d->seed << 5;
+  return d->seed / 4294967296.0;
+}
+/**
+ * pick a room and sensor for device number i
+ */
+void fleet_model(fleet_device *d, int i){
+  d->seed = 2463534242u + 7919u * i;
+  d->base = 25 + 35 * fleet_random(d);
+  d->swing = 10 * fleet_random(d);
+  d->phase = fleet_random(d);
+  d->temperature = 17 + 9 * fleet_random(d);
+  //one device in ten has a sensor that fails now and then
+  d->fail_rate = fleet_random(d) < 0.1 ? 0.5 * fleet_random(d) : 0;
+  d->jump = 0;
+  d->jump_end = 0;
+}
+/**
+ * what the DHT22 reads now, or an error.
+ * about once an hour the humidity jumps by
+ * 5 - 25% for 2 - 15 minutes
+ */
+int fleet_sensor(fleet_device *d, dht22 *sensor){
+  unsigned long now = millis();
+  if(now >= d->jump_end){
+    d->jump = 0;
+    if(fleet_random(d) < DHT22_PERIOD_MS / 3600000.0){
+      d->jump = 5 + 20 * fleet_random(d);
+      d->jump_end = now + (unsigned long)((2 + 13 * fleet_random(d)) * 60000);
+    }
+  }
+  if(fleet_random(d) < d->fail_rate){
+    return DHT22_ERROR_TIMEOUT;
+  }
+  double day = now / FLEET_DAY_MS + d->phase;
+  double humidity = d->base + d->swing * sin(2 * M_PI * day) + d->jump + (fleet_random(d) - 0.5);
+  sensor->humidity = round(constrain(humidity, 0.0, 99.9) * 10) / 10;
+  sensor->temperature = round((d->temperature + fleet_random(d) - 0.5) * 10) / 10;
+  return DHT22_OK;
+}
+/**
+ * the DHT22 part of acquire_sensors(),
+ * with the model in place of the wire
+ */
+void fleet_acquire(fleet_device *d){
+  if(millis() - ctx->acquire_last < DHT22_PERIOD_MS){
+    return;
+  }
+  ctx->acquire_last = millis();
+  if(!ctx->dht_health[0].due(ctx->acquire_last)){
+    return;
+  }
+  ctx->dht_status[0] = fleet_sensor(d, &ctx->dht_sensors[0]);
+  ctx->dht_health[0].record(ctx->dht_status[0], ctx->acquire_last);
+  if(ctx->dht_status[0] == DHT22_OK){
+    set_channel(ctx->dht_channel[0], ctx->dht_sensors[0].humidity);
+    update_climate(0);
+  }
+  ctx->chk = ctx->dht_status[0];
+}
+/**
+ * run one device from power on for the given
+ * time, on the calling thread
+ */
+void fleet_run(fleet_device *d, unsigned long run_ms){
+  set_device(&d->state);
+  host_us = 0;
+  //setup()
+  set_log_storage(&d->log);
+  log_recover();
+  add_dht_sensor(ctx->DHTPIN);
+  set_anomaly_alarm(4, 0);
+  delay(1000);
+  //loop()
+  d->full_ms = -1;
+  while(millis() < run_ms){
+    speakjet.sent = 0;
+    fleet_acquire(d);
+    check_anomalies();
+    activate_bargraph();
+    if(ctx->control_val==WRITE && rom_sample_due()){
+      mem_write();
+    }
+    clear_step();
+    increment_timer();
+    delay(ctx->global_delay);
+
+    if(speakjet.sent == humidity_sounds){
+      d->humidity_alarms++;
+    }else if(speakjet.sent == anomaly_sounds){
+      d->anomaly_alarms++;
+    }
+    if(d->full_ms < 0 && ctx->control_val == READ){
+      d->full_ms = millis();
+    }
+  }
+}
+
+/***************************
+ * WORK STEALING POOL
+ ***************************/
+struct fleet_queue
+{
+  std::mutex lock;
+  std::deque<int> tasks;
+};
+
+struct fleet_pool
+{
+  std::vector<fleet_queue> queues;
+  std::atomic<long> steals;
+
+  fleet_pool(int workers) : queues(workers), steals(0) {}
+
+  /**
+   * next device for a worker, -1 once
+   * every queue is empty
+   */
+  int next(int worker){
+    {
+      std::lock_guard<std::mutex> hold(queues[worker].lock);
+      if(!queues[worker].tasks.empty()){
+        int task = queues[worker].tasks.back();
+        queues[worker].tasks.pop_back();
+        return task;
+      }
+    }
+    //steal the oldest task of the next worker that has one
+    for(size_t k = 1; k<queues.size(); k++){
+      fleet_queue &victim = queues[(worker + k) % queues.size()];
+      std::lock_guard<std::mutex> hold(victim.lock);
+      if(!victim.tasks.empty()){
+        int task = victim.tasks.front();
+        victim.tasks.pop_front();
+        steals++;
+        return task;
+      }
+    }
+    return -1;
+  }
+};
+
+/***************************
+ * REPORT
+ ***************************/
+/**
+ * the value a share p of the way
+ * through a sorted list
+ */
+double fleet_quantile(const std::vector<double> &sorted, double p){
+  return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+void fleet_report(fleet_device *fleet, int devices, double hours){
+  double humidity = 0, anomaly = 0;
+  int humidity_devices = 0, anomaly_devices = 0;
+  std::vector<double> full;
+  for(int i = 0; i<devices; i++){
+    humidity += fleet[i].humidity_alarms;
+    anomaly += fleet[i].anomaly_alarms;
+    humidity_devices += fleet[i].humidity_alarms > 0;
+    anomaly_devices += fleet[i].anomaly_alarms > 0;
+    if(fleet[i].full_ms >= 0){
+      full.push_back(fleet[i].full_ms / 3600000.0);
+    }
+  }
+  double device_hours = devices * hours;
+  printf("humidity alarms  %.3f per device hour, %.1f%% of devices\n",
+         humidity / device_hours, 100.0 * humidity_devices / devices);
+  printf("anomaly alarms   %.3f per device hour, %.1f%% of devices\n",
+         anomaly / device_hours, 100.0 * anomaly_devices / devices);
+  printf("logs full        %.1f%% of devices", 100.0 * full.size() / devices);
+  if(!full.empty()){
+    std::sort(full.begin(), full.end());
+    printf(", after %.2f / %.2f / %.2f / %.2f hours (min / median / p90 / max)",
+           full.front(), fleet_quantile(full, 0.5), fleet_quantile(full, 0.9), full.back());
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv){
+  int devices = 2000;
+  double hours = 12;
+  int threads = std::thread::hardware_concurrency();
+  if(argc >= 3){
+    devices = atoi(argv[1]);
+    hours = atof(argv[2]);
+  }
+  if(argc >= 4){
+    threads = atoi(argv[3]);
+  }
+  if(devices < 1 || hours <= 0){
+    fprintf(stderr, "usage: %s [devices hours [threads]]\n", argv[0]);
+    return 2;
+  }
+  if(threads < 1){
+    threads = 1;
+  }
+
+  fleet_device *fleet = new fleet_device[devices]();
+  fleet_pool pool(threads);
+  for(int i = 0; i<devices; i++){
+    fleet_model(&fleet[i], i);
+    pool.queues[i % threads].tasks.push_back(i);
+  }
+
+  unsigned long run_ms = (unsigned long)(hours * 3600000);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for(int w = 0; w<threads; w++){
+    workers.push_back(std::thread([&pool, fleet, run_ms, w](){
+      for(int task; (task = pool.next(w)) >= 0; ){
+        fleet_run(&fleet[task], run_ms);
+      }
+    }));
+  }
+  for(size_t w = 0; w<workers.size(); w++){
+    workers[w].join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("fleet            %d devices, %.1f hours each, %d threads\n", devices, hours, threads);
+  printf("took             %.1f s, %.0f device hours per second, %ld tasks stolen\n",
+         seconds, devices * hours / seconds, pool.steals.load());
+  fleet_report(fleet, devices, hours);
+  delete[] fleet;
+  return 0;
+}
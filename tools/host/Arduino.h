@@ -0,0 +1,167 @@
+/*####################################################################
+ * FILE: Arduino.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for the Arduino core so the whole sketch
+ *          (sensational_toy.ino and R24U.h) builds on a computer for
+ *          the checks and the fleet simulation in tools/.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Needs C++17 (g++ -std=c++17), the registers and the clock
+ *        are inline variables.
+ *
+ *        There is no board behind it: pins and registers are plain
+ *        variables, inputs read 0 and outputs go nowhere. Time only
+ *        moves when the sketch waits, delay() and delayMicroseconds()
+ *        add to host_us, and each micros() call takes a microsecond
+ *        so busy waits on it end.
+ *
+ *        Serial output goes to host_serial, dropped while it is 0,
+ *        and nothing ever comes in.
+ *
+ *        The registers, the clock and the Serial target are kept per
+ *        thread, and R24U_LOCAL makes the sketch's ctx and board
+ *        globals per thread too (see R24U.h), so each thread can run
+ *        devices of its own (see tools/fleet_sim.cpp).
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+
+#define ARDUINO 105
+#define R24U_LOCAL thread_local //see R24U.h
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define DEC 10
+#define HEX 16
+#define NOT_A_PORT 0
+
+//Leonardo analog pins
+static const uint8_t A0 = 18, A1 = 19, A2 = 20, A3 = 21, A4 = 22, A5 = 23;
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+#define clockCyclesPerMicrosecond() ( F_CPU / 1000000L )
+#define microsecondsToClockCycles(a) ( (a) * clockCyclesPerMicrosecond() )
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define F(s) (s)
+
+/***************************
+ * CLOCK
+ ***************************/
+inline thread_local unsigned long host_us = 0; //microseconds since the device started
+
+inline unsigned long micros() { return host_us++; }
+inline unsigned long millis() { return host_us / 1000; }
+inline void delay(unsigned long ms) { host_us += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { host_us += us; }
+
+/***************************
+ * PINS
+ * every pin is on PORTB, only
+ * the bit follows the pin
+ ***************************/
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline int analogRead(uint8_t) { return 0; }
+inline void analogWrite(uint8_t, int) {}
+inline unsigned long pulseIn(uint8_t, uint8_t, unsigned long = 1000000L) { return 0; }
+inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+
+inline uint8_t digitalPinToPort(uint8_t) { return 2; }
+inline uint8_t digitalPinToBitMask(uint8_t pin) { return 1 << (pin & 7); }
+inline volatile uint8_t *portOutputRegister(uint8_t) { return &PORTB; }
+inline volatile uint8_t *portInputRegister(uint8_t) { return &PINB; }
+inline volatile uint8_t *portModeRegister(uint8_t) { return &DDRB; }
+
+/***************************
+ * SERIAL
+ ***************************/
+inline thread_local FILE *host_serial = 0; //where Serial output goes, 0 drops it
+
+class Print
+{
+  public:
+    virtual size_t write(uint8_t) = 0;
+    size_t write(const uint8_t *buffer, size_t size) {
+      for (size_t i = 0; i < size; i++)
+        write(buffer[i]);
+      return size;
+    }
+
+    size_t print(const char *s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC) {
+      char s[24];
+      snprintf(s, sizeof(s), base == HEX ? "%lX" : "%ld", n);
+      return print(s);
+    }
+    size_t print(unsigned long n, int base = DEC) {
+      char s[24];
+      snprintf(s, sizeof(s), base == HEX ? "%lX" : "%lu", n);
+      return print(s);
+    }
+    size_t print(double n, int digits = 2) {
+      char s[32];
+      snprintf(s, sizeof(s), "%.*f", digits, n);
+      return print(s);
+    }
+
+    size_t println() { return print("\r\n"); }
+    template<class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print
+{
+  public:
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush() {}
+};
+
+class Serial_ : public Stream
+{
+  public:
+    void begin(long) {}
+    operator bool() { return true; }
+    using Print::write;
+    size_t write(uint8_t b) {
+      if (host_serial)
+        fputc(b, host_serial);
+      return 1;
+    }
+};
+
+inline Serial_ Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,34 @@
+/*####################################################################
+ * FILE: SoftwareSerial.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for the SoftwareSerial library for host builds
+ *          (see Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Output goes nowhere, but the last string printed is kept
+ *        in sent, which is how tools/fleet_sim.cpp tells which sound
+ *        the SpeakJet was asked to play.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_SOFTWARESERIAL_H
+#define HOST_SOFTWARESERIAL_H
+
+#include "Arduino.h"
+
+class SoftwareSerial : public Stream
+{
+  public:
+    SoftwareSerial(uint8_t, uint8_t) : sent(0) {}
+    void begin(long) {}
+    using Print::print;
+    size_t print(const char *s) { sent = s; return Print::print(s); }
+    size_t write(uint8_t) { return 1; }
+
+    const char *sent; //last string printed
+};
+
+#endif // HOST_SOFTWARESERIAL_H
@@ -0,0 +1,33 @@
+/*####################################################################
+ * FILE: eeprom.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <avr/eeprom.h> for host builds (see
+ *          ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Each thread has its own E2END + 1 bytes, blank to start with.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+
+struct host_eeprom_bytes
+{
+  uint8_t bytes[E2END + 1];
+  host_eeprom_bytes() { memset(bytes, 0xFF, sizeof(bytes)); }
+};
+inline thread_local host_eeprom_bytes host_eeprom;
+
+inline uint8_t eeprom_read_byte(const uint8_t *address) { return host_eeprom.bytes[(uintptr_t)address & E2END]; }
+inline void eeprom_write_byte(uint8_t *address, uint8_t value) { host_eeprom.bytes[(uintptr_t)address & E2END] = value; }
+inline void eeprom_busy_wait() {}
+
+#endif // HOST_AVR_EEPROM_H
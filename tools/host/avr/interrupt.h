@@ -0,0 +1,24 @@
+/*####################################################################
+ * FILE: interrupt.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <avr/interrupt.h> for host builds (see
+ *          ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Nothing interrupts the sketch on a computer, so an ISR is
+ *        a plain function that is never called unless a check calls
+ *        it, and cli()/sei() do nothing.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#define ISR(vector) extern "C" void vector(void)
+#define cli() ((void)0)
+#define sei() ((void)0)
+
+#endif // HOST_AVR_INTERRUPT_H
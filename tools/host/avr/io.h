@@ -0,0 +1,67 @@
+/*####################################################################
+ * FILE: io.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <avr/io.h>, the ATmega32U4 registers and bits
+ *          the sketch uses, for host builds (see ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Registers are plain per thread variables. SPSR starts with
+ *        SPIF set so every SPI transfer finishes at once, and EECR
+ *        never shows the EEPROM busy.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#define __AVR_ATmega32U4__ 1
+#define _BV(bit) (1 << (bit))
+
+#define RAMSTART 0x100
+#define RAMEND 0xAFF
+#define E2END 0x3FF
+
+#define HOST_REGISTER(name) inline thread_local volatile uint8_t name = 0;
+HOST_REGISTER(PORTB) HOST_REGISTER(PORTC) HOST_REGISTER(PORTD) HOST_REGISTER(PORTE) HOST_REGISTER(PORTF)
+HOST_REGISTER(DDRB) HOST_REGISTER(DDRC) HOST_REGISTER(DDRD) HOST_REGISTER(DDRE) HOST_REGISTER(DDRF)
+HOST_REGISTER(PINB) HOST_REGISTER(PINC) HOST_REGISTER(PIND) HOST_REGISTER(PINE) HOST_REGISTER(PINF)
+HOST_REGISTER(SREG) HOST_REGISTER(MCUSR) HOST_REGISTER(WDTCSR)
+HOST_REGISTER(EECR) HOST_REGISTER(EEDR)
+HOST_REGISTER(SPDR) HOST_REGISTER(SPCR)
+HOST_REGISTER(TCCR0A) HOST_REGISTER(TCCR0B) HOST_REGISTER(TIMSK0) HOST_REGISTER(OCR0A) HOST_REGISTER(OCR0B)
+HOST_REGISTER(TCCR1A) HOST_REGISTER(TCCR1B) HOST_REGISTER(TIMSK1) HOST_REGISTER(TIFR1)
+HOST_REGISTER(EICRA) HOST_REGISTER(EICRB) HOST_REGISTER(EIMSK) HOST_REGISTER(EIFR)
+HOST_REGISTER(PCICR) HOST_REGISTER(PCMSK0)
+#undef HOST_REGISTER
+inline thread_local volatile uint8_t SPSR = 0x80; //SPIF
+inline thread_local volatile uint16_t EEAR = 0;
+inline thread_local volatile uint16_t TCNT1 = 0;
+
+//EEPROM
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+//SPI
+#define SPIF 7
+#define SPIE 7
+//timers
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOIE1 0
+#define TOV1 0
+#define CS10 0
+//pin change
+#define PCIE0 0
+//watchdog
+#define WDRF 3
+#define WDE 3
+#define WDCE 4
+#define WDIE 6
+
+#endif // HOST_AVR_IO_H
@@ -0,0 +1,25 @@
+/*####################################################################
+ * FILE: pgmspace.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <avr/pgmspace.h> so the sketch's table code
+ *          (Climate.h) builds on a computer for the checks in tools/.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: A computer has one address space, so tables stay in normal
+ *        memory and the reads are plain ones.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+
+#endif // HOST_PGMSPACE_H
@@ -0,0 +1,27 @@
+/*####################################################################
+ * FILE: wdt.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <avr/wdt.h> for host builds (see ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: There is no watchdog, so a hang is never restarted.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+#include <stdint.h>
+
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+
+inline void wdt_reset() {}
+inline void wdt_enable(uint8_t) {}
+inline void wdt_disable() {}
+
+#endif // HOST_AVR_WDT_H
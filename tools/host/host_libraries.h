@@ -0,0 +1,68 @@
+/*####################################################################
+ * FILE: host_libraries.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Bodies for the library classes sensational_toy/ only has
+ *          headers for (dht22, SFEbarGraph, SPI, EEPROM), so a host
+ *          build of the sketch links (see Arduino.h). Only what the
+ *          sketch calls is here.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Include once, after sensational_toy.ino. There is no
+ *        hardware behind them: a DHT22 never answers and the
+ *        bargraph shows nothing. A check that needs readings sets
+ *        them itself.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_LIBRARIES_H
+#define HOST_LIBRARIES_H
+
+/***************************
+ * DHT22
+ ***************************/
+dht22::dht22() : humidity(0), temperature(0), _BUSenabled(false), _sensorPin(2) {}
+dht22::dht22(int pin) : dht22() { attach(pin); }
+dht22::dht22(int pin, VersalinoBUS myBUS) : dht22() { attach(pin, myBUS); }
+void dht22::attach(int pin) { _sensorPin = pin; _BUSenabled = false; }
+void dht22::attach(int pin, VersalinoBUS myBUS) { _sensorPin = pin; setBUS(myBUS); }
+VersalinoBUS dht22::getBUS() { return _myBUS; }
+void dht22::setBUS(VersalinoBUS myBUS) { _myBUS = myBUS; _BUSenabled = true; }
+void dht22::removeBUS() { _BUSenabled = false; }
+int dht22::read() { start(); return finish(); }
+int dht22::read(int pin) { attach(pin); return read(); }
+int dht22::read(int pin, VersalinoBUS myBUS) { attach(pin, myBUS); return read(); }
+
+/***************************
+ * SPARKFUN BARGRAPH
+ ***************************/
+SFEbarGraph::SFEbarGraph() {}
+boolean SFEbarGraph::begin() { return true; }
+boolean SFEbarGraph::begin(unsigned char) { return true; }
+boolean SFEbarGraph::begin(unsigned char, unsigned char) { return true; }
+void SFEbarGraph::barGraph(unsigned char, unsigned char) {}
+void SFEbarGraph::clear() {}
+void SFEbarGraph::paint(unsigned char, boolean) {}
+void SFEbarGraph::send() {}
+void SFEbarGraph::sendLong(unsigned long) {}
+
+/***************************
+ * SPI
+ ***************************/
+SPIClass SPI;
+void SPIClass::begin() {}
+void SPIClass::end() {}
+void SPIClass::setBitOrder(uint8_t) {}
+void SPIClass::setDataMode(uint8_t) {}
+void SPIClass::setClockDivider(uint8_t) {}
+
+/***************************
+ * EEPROM
+ ***************************/
+EEPROMClass EEPROM;
+uint8_t EEPROMClass::read(int address) { return eeprom_read_byte((const uint8_t*)(uintptr_t)address); }
+void EEPROMClass::write(int address, uint8_t value) { eeprom_write_byte((uint8_t*)(uintptr_t)address, value); }
+
+#endif // HOST_LIBRARIES_H
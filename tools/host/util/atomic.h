@@ -0,0 +1,22 @@
+/*####################################################################
+ * FILE: atomic.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <util/atomic.h> for host builds (see
+ *          ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: No interrupts to hold off, the block just runs once.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#define ATOMIC_BLOCK(type) for (int host_atomic_once = 1; host_atomic_once; host_atomic_once = 0)
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#endif // HOST_UTIL_ATOMIC_H
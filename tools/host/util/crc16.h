@@ -0,0 +1,29 @@
+/*####################################################################
+ * FILE: crc16.h
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Stand in for <util/crc16.h> for host builds (see
+ *          ../Arduino.h).
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * NOTES: Same results as avr-libc's, so logs checked on a computer
+ *        match the board's.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#ifndef HOST_UTIL_CRC16_H
+#define HOST_UTIL_CRC16_H
+
+#include <stdint.h>
+
+//CRC-8, polynomial 0x07
+inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (int i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+}
+
+#endif // HOST_UTIL_CRC16_H
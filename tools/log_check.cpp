@@ -0,0 +1,280 @@
+/*####################################################################
+ * FILE: log_check.cpp
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Runs the sketch's log code (R24U.h) on a computer against
+ *          FileStorage (LogStorage.h) and checks it finds the end of
+ *          the log, tells good records from torn ones and recovers
+ *          from a power loss part way through a write or a clear.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * USAGE: g++ -std=c++17 -Wno-narrowing -I tools/host -I sensational_toy \
+ *            -o log_check tools/log_check.cpp
+ *        ./log_check [file]
+ *
+ *        file is where the log is kept while the checks run
+ *        (log_check.bin by default), it is removed at the end.
+ *
+ *        Prints one line per check and exits with 1 if any failed.
+ *
+ * NOTES: A restart is a new device (see set_device()) and a new
+ *        FileStorage on the same file, followed by log_recover() as
+ *        in setup(). A power loss part way through a record is made
+ *        by writing only its first bytes, as the EEPROM queue and
+ *        the flash page program both write in order.
+ *
+ *        int is wider here than on the board, the sequence number is
+ *        compared as the 16 bits the header keeps.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#include <string>
+#include "sensational_toy.ino"
+#include "host_libraries.h"
+
+#define CHECK_LOG_BYTES 1024 //the size of the Leonardo's EEPROM
+
+const char *log_path = "log_check.bin";
+FileStorage *log_file = 0;
+device *booted = 0; //the device since the last restart
+int failed = 0;
+
+/**
+ * restart the device on the log file,
+ * a new one if fresh is set
+ */
+void restart(int fresh){
+  delete log_file;
+  if(fresh){
+    remove(log_path);
+  }
+  log_file = new FileStorage(log_path, CHECK_LOG_BYTES);
+  delete booted;
+  booted = new device;
+  set_device(booted);
+  set_log_storage(log_file);
+  log_recover();
+}
+/**
+ * print a check's result
+ */
+void report(const char *name, int ok, const char *detail){
+  printf("%-16s %s%s%s\n", name, ok ? "ok" : "FAIL", ok ? "" : "  ", ok ? "" : detail);
+  failed |= !ok;
+}
+/**
+ * write the first bytes of the next record only,
+ * as a power loss part way through log_write()
+ */
+void torn_write(byte header, byte data, int bytes){
+  unsigned long addr = ctx->address_val * REC_SIZE;
+  unsigned int seq = ctx->log_base + ctx->address_val;
+  byte record[REC_SIZE] = {header, data, (byte)(seq & 0xFF), log_crc(seq, header, data)};
+  for(int j = 0; j<bytes; j++){
+    ctx->log_store->write(addr + j, record[j]);
+  }
+  ctx->log_store->sync();
+}
+/**
+ * the slots holding records, found one by one
+ */
+long used_slots(){
+  long used = 0;
+  for(long i = 0; i<ctx->log_slots; i++){
+    if(!log_blank(i)){
+      used = i + 1;
+    }
+  }
+  return used;
+}
+/**
+ * send the log the way read_step() does and
+ * return what went over Serial
+ */
+std::string read_log(){
+  char *text = 0;
+  size_t length = 0;
+  host_serial = open_memstream(&text, &length);
+  read_begin();
+  for(long i = 0; i<ctx->address_val; ){
+    i = read_record(i);
+  }
+  fclose(host_serial);
+  host_serial = 0;
+  std::string out(text, length);
+  free(text);
+  //lines end in \r\n on the board
+  for(size_t p; (p = out.find('\r')) != std::string::npos; ){
+    out.erase(p, 1);
+  }
+  return out;
+}
+
+/***************************
+ * CHECKS
+ ***************************/
+/**
+ * a new file comes up blank with a good header
+ */
+void check_fresh(){
+  restart(1);
+  int ok = ctx->address_val == 0 && ctx->control_val == WRITE && used_slots() == 0
+        && ctx->log_slots == (CHECK_LOG_BYTES - LOG_HEADER_SIZE) / REC_SIZE;
+  restart(0);
+  ok = ok && ctx->address_val == 0;
+  report("fresh", ok, "a new log isn't empty");
+}
+/**
+ * log_find_head() lands on the first blank slot for
+ * every length of log, and each record before it
+ * passes log_valid()
+ */
+void check_head(){
+  char detail[64] = "";
+  int ok = 1;
+  restart(1);
+  long slots = ctx->log_slots;
+  for(long n = 0; n<=slots && ok; n++){
+    restart(1);
+    for(long i = 0; i<n; i++){
+      log_write(1, i);
+    }
+    restart(0);
+    if(ctx->address_val != n || log_find_head() != used_slots()){
+      snprintf(detail, sizeof(detail), "%ld records, head at %ld", n, ctx->address_val);
+      ok = 0;
+    }
+    for(long i = 0; i<n && ok; i++){
+      if(!log_valid(i)){
+        snprintf(detail, sizeof(detail), "%ld records, slot %ld invalid", n, i);
+        ok = 0;
+      }
+    }
+    if(ok && n < slots && log_valid(n)){
+      snprintf(detail, sizeof(detail), "%ld records, blank slot valid", n);
+      ok = 0;
+    }
+  }
+  report("head", ok, detail);
+}
+/**
+ * a record cut short mid log is kept out of the
+ * read, never written over, and the records after
+ * the restart carry on past it
+ */
+void check_torn_record(){
+  char detail[64] = "";
+  int ok = 1;
+  for(int bytes = 1; bytes<REC_SIZE && ok; bytes++){
+    restart(1);
+    for(int i = 0; i<10; i++){
+      log_write(1, 40 + i);
+    }
+    torn_write(1, 99, bytes);
+    restart(0);
+    log_write(1, 60);
+    log_write(1, 61);
+    std::string want = "#13\n";
+    for(int i = 0; i<10; i++){
+      want += "1," + std::to_string(40 + i) + "\n";
+    }
+    want += "1,60\n1,61\n";
+    if(ctx->address_val != 13 || log_valid(10) || !log_valid(11) || read_log() != want){
+      snprintf(detail, sizeof(detail), "cut after %d bytes", bytes);
+      ok = 0;
+    }
+  }
+  report("torn record", ok, detail);
+}
+/**
+ * an anchor cut short leaves out all of its
+ * parts, the samples around it are still read
+ */
+void check_torn_anchor(){
+  char detail[64] = "";
+  int ok = 1;
+  for(int part = 0; part<ANCHOR_BYTES && ok; part++){
+    restart(1);
+    write_anchor(1000);
+    log_write(1, 50);
+    //the anchor that is cut short, part by part
+    for(int j = 0; j<part; j++){
+      log_write(REC_ANCHOR | j, 0);
+    }
+    torn_write(REC_ANCHOR | part, 0, 2);
+    restart(0);
+    write_anchor(2000);
+    log_write(1, 60);
+    if(read_log() != "#" + std::to_string(ctx->address_val) + "\n~1000\n1,50\n~2000\n1,60\n"){
+      snprintf(detail, sizeof(detail), "cut in part %d", part);
+      ok = 0;
+    }
+  }
+  report("torn anchor", ok, detail);
+}
+/**
+ * a clear cut short by a power loss (the header
+ * still says LOG_CLEARING) or a damaged header is
+ * finished by log_recover()
+ */
+void check_cut_clear(){
+  restart(1);
+  for(int i = 0; i<20; i++){
+    log_write(1, i);
+  }
+  log_write_header(LOG_CLEARING);
+  //the first few slots were cleared before the power went
+  ctx->log_store->erase(0, 3 * REC_SIZE);
+  restart(0);
+  int ok = ctx->address_val == 0 && used_slots() == 0 && ctx->log_store->read(ctx->log_header + 2) == 0;
+  report("cut clear", ok, "records left after the restart");
+
+  restart(1);
+  for(int i = 0; i<20; i++){
+    log_write(1, i);
+  }
+  ctx->log_store->write(ctx->log_header + 3, ctx->log_store->read(ctx->log_header + 3) ^ 0x55);
+  restart(0);
+  ok = ctx->address_val == 0 && used_slots() == 0;
+  report("bad header", ok, "records left after the restart");
+}
+/**
+ * reset_mem() and clear_step() blank the old
+ * records a little at a time and the sequence
+ * carries on across the reset and a restart
+ */
+void check_reset(){
+  restart(1);
+  unsigned int base = ctx->log_base;
+  for(int i = 0; i<20; i++){
+    log_write(1, i);
+  }
+  reset_mem();
+  int steps = 0;
+  while(ctx->clear_end && steps < 1000){
+    clear_step();
+    steps++;
+  }
+  log_write(1, 70);
+  restart(0);
+  int ok = !ctx->clear_end && (uint16_t)ctx->log_base == (uint16_t)(base + 20) && ctx->address_val == 1
+        && log_valid(0) && used_slots() == 1 && read_log() == "#1\n1,70\n";
+  report("reset", ok, "the log wasn't cleared");
+}
+
+int main(int argc, char **argv){
+  if(argc >= 2){
+    log_path = argv[1];
+  }
+  check_fresh();
+  check_head();
+  check_torn_record();
+  check_torn_anchor();
+  check_cut_clear();
+  check_reset();
+  delete log_file;
+  remove(log_path);
+  return failed;
+}
@@ -0,0 +1,90 @@
+#!/bin/sh
+#####################################################################
+# FILE: ram_report.sh
+# AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+# VERSION: 1.0
+# PURPOSE: Lists how much SRAM the globals of each source file take
+#          in a built sketch, largest first, and checks they and the
+#          heap leave enough room for the stack.
+# LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+#
+# USAGE: tools/ram_report.sh sensational_toy.ino.elf [stack bytes [heap bytes]]
+#
+#        Not part of the build, run it by hand after building. The
+#        .elf is in the build folder (turn on verbose output during
+#        compilation in the Arduino preferences to see where, or
+#        build with arduino-cli --build-path). stack bytes is how
+#        much of the 2560 bytes must be left for the stack, 512 if
+#        not given. heap bytes is what setup() mallocs, 6 if not
+#        given: SFEbarGraph::begin() takes 4 bytes for one board's
+#        canvas plus malloc's 2 (see MemWatch.h). Exits with 1 if
+#        the globals and the heap take more than the 2560 bytes or
+#        don't leave that much for the stack.
+#
+#        The total is the size of the .data, .bss and .noinit
+#        sections (from avr-size), which also counts padding and
+#        anything without a symbol, so it can be a little more than
+#        the files listed add up to.
+#
+#        Files come from the debug information, which the Arduino
+#        build includes. Globals without it (from libraries built
+#        elsewhere) are listed as "(no source)".
+#####################################################################
+
+ELF=$1
+STACK=${2:-512}
+HEAP=${3:-6}
+SRAM=2560
+NM=${NM:-avr-nm}
+SIZE=${SIZE:-avr-size}
+
+if [ -z "$ELF" ] || [ ! -f "$ELF" ]; then
+  echo "usage: $0 sketch.elf [stack bytes [heap bytes]]" >&2
+  exit 2
+fi
+
+# everything the globals take, e.g.
+#   .data      286   8388864
+USED=$($SIZE -A "$ELF" | awk '$1 == ".data" || $1 == ".bss" || $1 == ".noinit" { used += $2 } END { print used + 0 }')
+if [ -z "$USED" ]; then
+  echo "$SIZE could not read $ELF" >&2
+  exit 2
+fi
+
+# data and bss symbols with their size and file, e.g.
+#   00800100 00000002 D ctx	/path/R24U.h:265
+$NM -S -l -t d "$ELF" | awk -v stack="$STACK" -v heap="$HEAP" -v sram="$SRAM" -v used="$USED" -F '\t' '
+{
+  split($1, f, " ")
+  if (f[4] == "" || f[3] !~ /^[bBdD]$/) next
+  file = "(no source)"
+  if ($2 != "") {
+    file = $2
+    sub(/:[0-9]+$/, "", file)
+    sub(/.*\//, "", file)
+  }
+  bytes[file] += f[2] + 0
+  total += f[2] + 0
+}
+END {
+  for (file in bytes)
+    printf "%6d  %s\n", bytes[file], file | "sort -rn"
+  close("sort -rn")
+  if (used < total)
+    used = total
+  printf "%6d  listed\n", total
+  printf "%6d  globals\n", used
+  printf "%6d  heap\n", heap
+  used += heap
+  printf "%6d  total of %d, %d left for the stack (%d wanted)\n", used, sram, sram - used, stack
+  if (used > sram) {
+    fflush()
+    print "globals and heap take more than the " sram " bytes of SRAM" > "/dev/stderr"
+    exit 1
+  }
+  if (sram - used < stack) {
+    fflush()
+    print "globals and heap leave too little room for the stack" > "/dev/stderr"
+    exit 1
+  }
+}'
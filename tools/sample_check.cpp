@@ -0,0 +1,167 @@
+/*####################################################################
+ * FILE: sample_check.cpp
+ * AUTHORS: Matt Scaperoth, Niyi Odumosu, Joseph Burns
+ * VERSION: 1.0
+ * PURPOSE: Runs the log's sampling rule (sensational_toy/Sampling.h) on
+ *          a computer over recorded readings, rebuilds the trace the
+ *          host would get by holding each saved value, and checks it
+ *          stays within the bound Sampling.h promises.
+ * LICENSE: GPL v3 (http://www.gnu.org/licenses/gpl.html)
+ *
+ * USAGE: g++ -I sensational_toy -o sample_check tools/sample_check.cpp
+ *        ./sample_check [trace] [tolerance min_ticks max_ticks]
+ *
+ *        trace has one line per loop tick (100 ms by default), holding
+ *        the reading of each channel separated by spaces. Without one,
+ *        a few made up traces (flat, ramp, step, noise) are checked.
+ *        The settings default to the sketch's: rom_tolerance 2,
+ *        rom_fast_seconds 2 (20 ticks), rom_minutes 1 (600 ticks).
+ *        The made up traces are also run with rom_minutes .0017
+ *        (1 tick), shorter than rom_fast_seconds, as in
+ *          ./sample_check trace 2 20 1
+ *
+ *        Prints the samples saved and the worst error (from the first
+ *        save on) for each trace, and exits with 1 if the error stays
+ *        at the tolerance or more for longer than min_ticks.
+ *
+ * NOTES: Follows loop(): the reading comes in, rom_sample_due() and
+ *        mem_write() run, then increment_timer(). Failed sensor reads
+ *        and a full log are left out.
+ *
+ * HISTORY:
+ *
+ #######################################################################*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Sampling.h"
+
+#define MAX_CHANNELS 8
+
+typedef std::vector<std::vector<int> > trace;
+
+struct settings
+{
+  int tolerance;
+  int min_delay;
+  int max_delay;
+};
+
+/**
+ * run one trace, returns 0 if it is within the bound
+ */
+int check(const char *name, const trace &readings, const settings &set){
+  int last[MAX_CHANNELS] = {0};
+  int ticks = 0;
+  int sample_delay = set.min_delay;
+  long saved = 0;
+  int worst = 0;
+  int run = 0; //ticks in a row off by the tolerance or more
+  int longest = 0;
+
+  for(size_t t = 0; t<readings.size(); t++){
+    const std::vector<int> &now = readings[t];
+    int drifted = 0;
+    for(size_t c = 0; c<now.size(); c++){
+      if(abs(now[c] - last[c]) >= set.tolerance){
+        drifted = 1;
+      }
+    }
+    int due = sample_due(drifted, ticks, sample_delay, set.min_delay);
+    if(due){
+      for(size_t c = 0; c<now.size(); c++){
+        last[c] = now[c];
+      }
+      ticks = 0;
+      sample_delay = sample_next_delay(due, sample_delay, set.min_delay, set.max_delay);
+      saved++;
+    }
+
+    int error = 0;
+    for(size_t c = 0; c<now.size(); c++){
+      error = abs(now[c] - last[c]) > error ? abs(now[c] - last[c]) : error;
+    }
+    //before the first save there is nothing to hold
+    if(saved){
+      worst = error > worst ? error : worst;
+    }
+    run = error >= set.tolerance ? run + 1 : 0;
+    longest = run > longest ? run : longest;
+
+    if(ticks < sample_tick_limit(set.min_delay, set.max_delay)){
+      ticks++;
+    }
+  }
+
+  int ok = longest <= set.min_delay;
+  printf("%-8s %7lu ticks %6ld saved  worst error %d  off for %d ticks  %s\n",
+         name, (unsigned long)readings.size(), saved, worst, longest, ok ? "ok" : "FAIL");
+  return !ok;
+}
+/**
+ * one line per tick, channels separated by spaces
+ */
+int load(const char *path, trace &readings){
+  FILE *f = fopen(path, "r");
+  if(!f){
+    return 0;
+  }
+  char line[256];
+  while(fgets(line, sizeof(line), f)){
+    std::vector<int> now;
+    for(char *p = strtok(line, " \t\r\n"); p && now.size() < MAX_CHANNELS; p = strtok(0, " \t\r\n")){
+      now.push_back(atoi(p));
+    }
+    if(!now.empty()){
+      readings.push_back(now);
+    }
+  }
+  fclose(f);
+  return 1;
+}
+
+int main(int argc, char **argv){
+  settings set = {2, 20, 600};
+  if(argc >= 5){
+    set.tolerance = atoi(argv[2]);
+    set.min_delay = atoi(argv[3]);
+    set.max_delay = atoi(argv[4]);
+  }
+
+  if(argc >= 2){
+    trace readings;
+    if(!load(argv[1], readings)){
+      fprintf(stderr, "can't read %s\n", argv[1]);
+      return 2;
+    }
+    return check(argv[1], readings, set);
+  }
+
+  //an hour of each, at 10 ticks a second
+  const int length = 36000;
+  trace flat, ramp, step, noise;
+  srand(1);
+  for(int t = 0; t<length; t++){
+    flat.push_back(std::vector<int>(1, 45));
+    ramp.push_back(std::vector<int>(1, 30 + t/300));
+    step.push_back(std::vector<int>(1, (t/6000) % 2 ? 70 : 40));
+    std::vector<int> two;
+    two.push_back(50 + rand() % 5 - 2);
+    two.push_back(20 + t/1200 + rand() % 3 - 1);
+    noise.push_back(two);
+  }
+  //and with the longest wait below the shortest
+  settings short_max = {set.tolerance, set.min_delay, 1};
+  int failed = 0;
+  failed |= check("flat", flat, set);
+  failed |= check("ramp", ramp, set);
+  failed |= check("step", step, set);
+  failed |= check("noise", noise, set);
+  failed |= check("flat/1", flat, short_max);
+  failed |= check("ramp/1", ramp, short_max);
+  failed |= check("step/1", step, short_max);
+  failed |= check("noise/1", noise, short_max);
+  return failed;
+}